@@ -0,0 +1,334 @@
+#include "banim/animations.h"
+#include "banim/block.h"
+#include "banim/headless.h"
+#include "banim/logic_gates.h"
+#include "banim/scene.h"
+#include "banim/thread_pool.h"
+#include "banim/wire.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace banim;
+
+// Synthetic render benchmark. Builds scenes of Blocks, LogicGates, Wires and
+// Text at several scales and times Scene::update, Scene::renderScene and full
+// frame export (update + rasterize + copy-out through the headless path)
+// separately. Results are written as JSON for comparison between releases.
+// Before timing, it checks that batched drawing paints the same pixels as
+// unbatched drawing and exits with 1 if not.
+// Numbers are only meaningful from an optimized build:
+// cmake -DCMAKE_BUILD_TYPE=Release.
+//
+// Usage: banim_bench [--scales 100,1000,10000,50000] [--frames 60]
+//                    [--width 1920] [--height 1080] [--update-threads 1]
+//                    [--out results.json]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef __OPTIMIZE__
+constexpr bool kOptimized = true;
+#else
+constexpr bool kOptimized = false;
+#endif
+
+struct BenchOptions {
+    std::vector<int> scales{100, 1000, 10000, 50000};
+    int frames = 60;
+    int width = 1920;
+    int height = 1080;
+    int fps = 60;
+    int updateThreads = 1; // Scene::setUpdatePool, 0 = hardware concurrency
+    std::string out; // Empty = stdout
+};
+
+struct Summary {
+    double mean = 0, p50 = 0, p99 = 0, max = 0; // Milliseconds
+};
+
+struct ScaleResult {
+    int objects = 0;
+    double buildMs = 0;
+    Summary update, renderScene, exportFrame;
+};
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Summary summarize(std::vector<double> samples) {
+    Summary s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    auto rank = [&](double p) {
+        size_t k = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+        return samples[std::min(samples.size() - 1, k > 0 ? k - 1 : 0)];
+    };
+    for (double v : samples) s.mean += v;
+    s.mean /= static_cast<double>(samples.size());
+    s.p50 = rank(50);
+    s.p99 = rank(99);
+    s.max = samples.back();
+    return s;
+}
+
+// One unit is a Block wired into a gate, with a Text caption: four objects
+// in a 4 x 2 cell footprint. Units are tiled to roughly 16:9 and every tenth
+// block slides half a cell over the run so updates and re-routing have work.
+void buildScene(Scene &scene, int objects, const BenchOptions &opt) {
+    int units = std::max(1, (objects + 3) / 4);
+    int perRow = std::max(1, static_cast<int>(std::ceil(std::sqrt(units * 8.0 / 9.0))));
+    int unitRows = (units + perRow - 1) / perRow;
+
+    GridConfig grid(perRow * 4, unitRows * 2, false);
+    scene.setGridConfig(grid);
+    float cellHeight = static_cast<float>(opt.height) / static_cast<float>(grid.rows);
+    float fontSize = std::max(4.0f, cellHeight * 0.4f);
+
+    const float duration = static_cast<float>(opt.frames) / static_cast<float>(opt.fps);
+    std::vector<std::shared_ptr<Animation>> moves;
+    int added = 0;
+    for (int u = 0; u < units && added < objects; ++u) {
+        float x = static_cast<float>((u % perRow) * 4);
+        float y = static_cast<float>((u / perRow) * 2);
+
+        auto block = scene.make<Block>(GridCoord(x, y), 1.0f, 0.5f, "B" + std::to_string(u));
+        block->addPort(PortDirection::RIGHT, "out");
+        block->setColor(0.9f, 0.9f, 0.6f, 1.0f);
+        scene.addAnimatable(block);
+        ++added;
+
+        if (added < objects) {
+            auto gate = scene.make<LogicGate>(GateType::AND, PortDirection::RIGHT,
+                                              GridCoord(x + 2.0f, y), 1.0f, 1.0f);
+            scene.addAnimatable(gate);
+            ++added;
+
+            if (added < objects) {
+                scene.addAnimatable(scene.make<Wire>(block, "out", gate, "input1"));
+                ++added;
+            }
+        }
+        if (added < objects) {
+            scene.addAnimatable(scene.make<Text>(GridCoord(x, y + 1.0f),
+                                                 "unit " + std::to_string(u), fontSize));
+            ++added;
+        }
+
+        if (u % 10 == 0)
+            moves.push_back(scene.make<MoveTo>(block, GridCoord(x + 0.5f, y), duration));
+    }
+    if (!moves.empty())
+        scene.playGroup(moves);
+}
+
+// PathBatcher merges objects of one style into a single path, which must
+// paint the same pixels as drawing them one by one. Filled and stroked
+// circles without sprite caching are batched, a few cells apart.
+bool batchingMatches(const BenchOptions &opt) {
+    Scene scene;
+    scene.setGridConfig(GridConfig(32, 18, false));
+    std::vector<std::shared_ptr<Circle>> circles;
+    for (int i = 0; i < 64; ++i) {
+        auto circle = scene.make<Circle>(GridCoord((i % 16) * 2.0f, (i / 16) * 4.0f + (i % 2) * 2.0f),
+                                         1.0f, 1.0f);
+        circle->setSpriteCaching(false);
+        circle->setColor(0.9f, 0.5f, 0.2f, 1.0f);
+        circle->setFilled(i % 2 == 0);
+        circles.push_back(circle);
+    }
+
+    RenderContext ctx = scene.renderContext(opt.width, opt.height);
+    CairoSurface batched(opt.width, opt.height), single(opt.width, opt.height);
+    for (CairoSurface *target : {&batched, &single}) {
+        cairo_t *cr = target->context();
+        cairo_save(cr);
+        cairo_set_source_rgb(cr, 0.1, 0.1, 0.15);
+        cairo_paint(cr);
+        cairo_translate(cr, ctx.originX, ctx.originY);
+        PathBatcher batch(cr, ctx);
+        for (auto &circle : circles) {
+            circle->prepareDraw(ctx);
+            if (target == &batched)
+                batch.draw(*circle, circle->getPixelBounds(ctx));
+            else
+                circle->draw(cr, ctx);
+        }
+        batch.flush();
+        cairo_restore(cr);
+        cairo_surface_flush(target->surface());
+    }
+
+    int stride = cairo_image_surface_get_stride(batched.surface());
+    return !std::memcmp(cairo_image_surface_get_data(batched.surface()),
+                        cairo_image_surface_get_data(single.surface()),
+                        static_cast<size_t>(stride) * opt.height);
+}
+
+ScaleResult runScale(int objects, const BenchOptions &opt) {
+    ScaleResult result;
+    result.objects = objects;
+    const float dt = 1.0f / static_cast<float>(opt.fps);
+
+    // Update and a renderScene of the whole frame per frame, without damage
+    // tracking: no static layer and no culling, so every object is drawn.
+    // Sprite and glyph caches still apply.
+    {
+        auto start = Clock::now();
+        Scene scene;
+        buildScene(scene, objects, opt);
+        result.buildMs = msSince(start);
+
+        std::unique_ptr<ThreadPool> updatePool;
+        if (opt.updateThreads != 1) {
+            updatePool = std::make_unique<ThreadPool>(opt.updateThreads);
+            scene.setUpdatePool(updatePool.get());
+        }
+
+        CairoSurface target(opt.width, opt.height);
+        RenderContext ctx = scene.renderContext(opt.width, opt.height);
+        std::vector<double> updates, renders;
+        for (int f = 0; f < opt.frames; ++f) {
+            start = Clock::now();
+            scene.update(dt);
+            updates.push_back(msSince(start));
+
+            cairo_t *cr = target.context();
+            start = Clock::now();
+            cairo_save(cr);
+            cairo_set_source_rgb(cr, 0.1, 0.1, 0.15);
+            cairo_paint(cr);
+            scene.renderScene(cr, ctx);
+            cairo_restore(cr);
+            cairo_surface_flush(target.surface());
+            renders.push_back(msSince(start));
+        }
+        result.update = summarize(std::move(updates));
+        result.renderScene = summarize(std::move(renders));
+    }
+
+    // Export: the headless frame loop with damage tracking and caches, plus
+    // copying each finished frame out as an encoder would
+    {
+        Scene scene;
+        buildScene(scene, objects, opt);
+        HeadlessOptions headless;
+        headless.width = opt.width;
+        headless.height = opt.height;
+        headless.fps = opt.fps;
+        headless.maxFrames = opt.frames;
+
+        std::vector<unsigned char> copy;
+        std::vector<double> frames;
+        auto last = Clock::now();
+        renderHeadless(scene, headless, [&](int, cairo_surface_t *frame) {
+            const unsigned char *data = cairo_image_surface_get_data(frame);
+            size_t bytes = static_cast<size_t>(cairo_image_surface_get_stride(frame)) *
+                           cairo_image_surface_get_height(frame);
+            copy.assign(data, data + bytes);
+            frames.push_back(msSince(last));
+            last = Clock::now();
+        });
+        result.exportFrame = summarize(std::move(frames));
+    }
+    return result;
+}
+
+void writeSummary(std::ostream &os, const char *name, const Summary &s) {
+    os << "\"" << name << "\": {\"mean_ms\": " << s.mean << ", \"p50_ms\": " << s.p50
+       << ", \"p99_ms\": " << s.p99 << ", \"max_ms\": " << s.max << "}";
+}
+
+void writeJson(std::ostream &os, const BenchOptions &opt, const std::vector<ScaleResult> &results) {
+    os << "{\n  \"benchmark\": \"banim_bench\",\n"
+       << "  \"width\": " << opt.width << ",\n  \"height\": " << opt.height << ",\n"
+       << "  \"frames\": " << opt.frames << ",\n  \"fps\": " << opt.fps << ",\n"
+       << "  \"update_threads\": " << opt.updateThreads << ",\n"
+       << "  \"optimized\": " << (kOptimized ? "true" : "false") << ",\n"
+       << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ScaleResult &r = results[i];
+        os << "    {\"objects\": " << r.objects << ", \"build_ms\": " << r.buildMs << ", ";
+        writeSummary(os, "update", r.update);
+        os << ", ";
+        writeSummary(os, "render_scene", r.renderScene);
+        os << ", ";
+        writeSummary(os, "export_frame", r.exportFrame);
+        os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+std::vector<int> parseList(const char *arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+bool parseArgs(int argc, char **argv, BenchOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!std::strcmp(arg, "--scales") && value) { opt.scales = parseList(value); ++i; }
+        else if (!std::strcmp(arg, "--frames") && value) { opt.frames = std::atoi(value); ++i; }
+        else if (!std::strcmp(arg, "--width") && value) { opt.width = std::atoi(value); ++i; }
+        else if (!std::strcmp(arg, "--height") && value) { opt.height = std::atoi(value); ++i; }
+        else if (!std::strcmp(arg, "--update-threads") && value) { opt.updateThreads = std::atoi(value); ++i; }
+        else if (!std::strcmp(arg, "--out") && value) { opt.out = value; ++i; }
+        else return false;
+    }
+    return !opt.scales.empty() && opt.frames > 0 && opt.width > 0 && opt.height > 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        std::cerr << "usage: banim_bench [--scales N,N,...] [--frames N] [--width W] "
+                     "[--height H] [--update-threads N] [--out FILE]" << std::endl;
+        return 2;
+    }
+
+    if (!kOptimized)
+        std::cerr << "banim_bench: built without optimization, timings are not "
+                     "representative (configure with -DCMAKE_BUILD_TYPE=Release)" << std::endl;
+
+    if (!batchingMatches(opt)) {
+        std::cerr << "banim_bench: batched drawing does not match drawing objects "
+                     "one by one" << std::endl;
+        return 1;
+    }
+
+    std::vector<ScaleResult> results;
+    for (int objects : opt.scales) {
+        std::cerr << "banim_bench: " << objects << " objects..." << std::endl;
+        results.push_back(runScale(objects, opt));
+    }
+
+    if (opt.out.empty()) {
+        writeJson(std::cout, opt, results);
+    } else {
+        std::ofstream file(opt.out);
+        if (!file) {
+            std::cerr << "banim_bench: cannot write " << opt.out << std::endl;
+            return 1;
+        }
+        writeJson(file, opt, results);
+    }
+    return 0;
+}
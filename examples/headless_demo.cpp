@@ -0,0 +1,48 @@
+#include "banim/headless.h"
+#include "banim/scene.h"
+#include "banim/animations.h"
+#include "banim/block.h"
+#include "banim/wire.h"
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+using namespace banim;
+
+// Renders a short timeline to frame_0000.png, frame_0001.png, ... without
+// opening a window. Usage: headless_demo [output_dir]
+int main(int argc, char **argv) {
+    const char *outDir = argc > 1 ? argv[1] : ".";
+
+    GridConfig gridConfig(16, 9, true);
+    Scene scene(gridConfig);
+
+    auto blockA = std::make_shared<Block>(GridCoord(2, 2), 2.0f, 1.0f, "Block A");
+    blockA->addPort(PortDirection::RIGHT, "output");
+
+    auto blockB = std::make_shared<Block>(GridCoord(6, 2), 2.0f, 1.0f, "Block B");
+    blockB->addPort(PortDirection::LEFT, "input");
+
+    auto wire = std::make_shared<Wire>(blockA, "output", blockB, "input");
+    wire->setColor(1.0f, 0.0f, 0.0f, 1.0f);
+
+    scene.add(blockA);
+    scene.add(blockB);
+    scene.add(wire);
+    scene.play(std::make_shared<MoveTo>(blockA, GridCoord(4, 4), 1.0f));
+    scene.wait(0.5f);
+
+    HeadlessOptions opts;
+    opts.width = 1280;
+    opts.height = 720;
+    opts.fps = 30;
+
+    int frames = renderHeadless(scene, opts, [outDir](int index, cairo_surface_t *frame) {
+        char path[512];
+        std::snprintf(path, sizeof(path), "%s/frame_%04d.png", outDir, index);
+        cairo_surface_write_to_png(frame, path);
+    });
+
+    std::cout << "Rendered " << frames << " frames to " << outDir << std::endl;
+    return 0;
+}
@@ -6,6 +6,13 @@
 #include <vector>
 #include <cmath>
 #include "banim/grid.h"
+#include "banim/damage.h"
+#include "banim/display_list.h"
+#include "banim/path_batch.h"
+#include "banim/render_context.h"
+#include "banim/sprite_cache.h"
+#include "banim/state_buffer.h"
+#include "banim/text_cache.h"
 
 namespace banim {
 
@@ -15,39 +22,53 @@ class Scene;
 class Animatable : public std::enable_shared_from_this<Animatable> {
 public:
     virtual ~Animatable() = default;
-    virtual void draw(cairo_t* cr) = 0;
+    
+    // Draw at the current alpha. By default this replays the display list
+    // prepareDraw recorded, or records a fresh one if that is out of date.
+    virtual void draw(cairo_t* cr, const RenderContext& ctx);
+    
+    // Record the object's drawing, in scene pixels, with fills and strokes at
+    // alpha. Called on the rendering thread when the object changed or the
+    // frame's cell size, zoom or detail threshold differ from the last list.
+    virtual void record(DisplayList& list, const RenderContext& ctx, float alpha) const {}
+    
+    // Rasterize directly (no sprite cache) with the fill/stroke alpha given
+    void render(cairo_t* cr, const RenderContext& ctx, float alpha) const;
     
     // Grid positioning
     virtual float gridX() const { return gridPos_.x; }
     virtual float gridY() const { return gridPos_.y; }
     virtual GridCoord getGridPos() const { return gridPos_; }
-    virtual void setGridPos(const GridCoord& pos) { gridPos_ = pos; }
-    virtual void setGridPos(float x, float y) { gridPos_ = {x, y}; }
+    virtual void setGridPos(const GridCoord& pos) { gridPos_ = pos; markDirty(); }
+    virtual void setGridPos(float x, float y) { gridPos_ = {x, y}; markDirty(); }
     
     // Grid sizing
     virtual float getGridWidth() const { return gridSize_.x; }
     virtual float getGridHeight() const { return gridSize_.y; }
-    virtual void setGridSize(float w, float h) { gridSize_ = {w, h}; }
-    virtual void setGridSize(const GridCoord& size) { gridSize_ = size; }
+    virtual void setGridSize(float w, float h) { gridSize_ = {w, h}; markDirty(); }
+    virtual void setGridSize(const GridCoord& size) { gridSize_ = size; markDirty(); }
     
     // Visibility and appearance
-    virtual void setAlpha(float alpha) { a_ = alpha; }
+    virtual void setAlpha(float alpha) { a_ = alpha; markDirty(); }
     virtual float getAlpha() const { return a_; }
     virtual void hide() { setAlpha(0.0f); }
     virtual void show() { setAlpha(1.0f); }
     
     virtual Animatable& setColor(float r, float g, float b, float a = 1.0f) {
         r_ = r; g_ = g; b_ = b; a_ = a;
+        markDirty();
         return *this;
     }
     
     virtual Animatable& setRotation(float angle) {
         rotation_ = angle;
+        markDirty();
         return *this;
     }
     
     virtual Animatable& setFilled(bool filled) {
         filled_ = filled;
+        markDirty();
         return *this;
     }
     
@@ -55,6 +76,7 @@ public:
     
     virtual Animatable& setStrokeWidth(float w) {
         strokeWidth_ = w;
+        markDirty();
         return *this;
     }
     
@@ -64,6 +86,41 @@ public:
     virtual void getAnimatableSize(float& w, float& h) const = 0;
     virtual void setAnimatableSize(float w, float h) = 0;
     virtual void resetForAnimation() = 0;
+    
+    // Timeline checkpoints: write every property an animation can change,
+    // and read them back in the same order. Overrides extend the base.
+    virtual void saveState(StateBuffer& state) const;
+    virtual void restoreState(StateBuffer& state);
+    
+    // Damage tracking: box in scene pixels (before the camera offset) covering
+    // everything draw() touches, stroke and antialiasing included
+    virtual PixelRect getPixelBounds(const RenderContext& ctx) const;
+    
+    // Bring derived geometry (e.g. wire routing) up to date before bounds are measured
+    virtual void syncGeometry() {}
+    
+    // Refresh per-object caches (display list, sprite, shaped text) on the
+    // rendering thread before a frame is drawn. Afterwards draw() only reads
+    // the object, so it may be called from several tile workers at once.
+    virtual void prepareDraw(const RenderContext& ctx) { updateDisplayList(ctx); }
+    
+    // Batched drawing: an object that this frame looks like one solid fill
+    // or stroke reports its style and adds its geometry with appendPath, and
+    // the Scene draws it together with others of the same style through a
+    // PathBatcher. Returns false for objects that must draw() themselves.
+    // By default both are derived from the recorded display list.
+    virtual bool pathStyle(const RenderContext& ctx, PathStyle& style) const;
+    virtual void appendPath(cairo_t* cr, const RenderContext& ctx) const { displayList_.appendPath(cr); }
+    
+    // Set whenever a property that affects drawing changes; cleared by the Scene
+    void markDirty() { dirty_ = true; ++version_; }
+    bool isDirty() const { return dirty_; }
+    void clearDirty() { dirty_ = false; }
+    
+    // Draw through a cached raster of the object where the type supports it
+    // (Rectangle, Block, Circle, Text), re-rasterizing only on visual changes
+    void setSpriteCaching(bool enable) { spriteCaching_ = enable; sprite_.clear(); }
+    bool isSpriteCaching() const { return spriteCaching_; }
 
 protected:
     GridCoord gridPos_{0, 0};
@@ -72,8 +129,23 @@ protected:
     float rotation_ = 0;
     float strokeWidth_ = 2.0f;
     bool filled_ = true;
+    bool dirty_ = true;
+    bool spriteCaching_ = true;
+    SpriteCache sprite_;
+    
+    // Re-record the display list if the object or the frame parameters it
+    // depends on changed since the last recording
+    void updateDisplayList(const RenderContext& ctx);
+    bool displayListCurrent(const RenderContext& ctx) const;
+
+private:
+    DisplayList displayList_;
+    unsigned version_ = 0;      // Bumped by markDirty
+    unsigned listVersion_ = ~0u; // version_ when displayList_ was recorded
+    float listCellWidth_ = 0, listCellHeight_ = 0, listZoom_ = 0, listDetail_ = 0;
 };
 
+
 class Rectangle : public Animatable {
 public:
     Rectangle(const GridCoord& gridPos, float gridWidth, float gridHeight,
@@ -84,7 +156,15 @@ public:
     Rectangle& setBorderRadius(float radius);
     float getBorderRadius() const { return borderRadius_; }
     
-    void draw(cairo_t* cr) override;
+    void draw(cairo_t* cr, const RenderContext& ctx) override;
+    void prepareDraw(const RenderContext& ctx) override;
+    void record(DisplayList& list, const RenderContext& ctx, float alpha) const override;
+    
+    // Unrotated square-cornered rectangles are batched instead of sprite cached
+    bool pathStyle(const RenderContext& ctx, PathStyle& style) const override;
+    
+    void saveState(StateBuffer& state) const override;
+    void restoreState(StateBuffer& state) override;
     
     void getAnimatableSize(float& w, float& h) const override {
         w = gridSize_.x;
@@ -102,6 +182,8 @@ public:
 private:
     float borderRadius_ = 0.0f;
     float duration_;
+    
+    SpriteCache::Key spriteKey(float cellWidth, float cellHeight) const;
 };
 
 class Circle : public Animatable {
@@ -111,7 +193,12 @@ public:
            float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 1.0f,
            float rotation = 0.0f);
     
-    void draw(cairo_t* cr) override;
+    void draw(cairo_t* cr, const RenderContext& ctx) override;
+    void prepareDraw(const RenderContext& ctx) override;
+    void record(DisplayList& list, const RenderContext& ctx, float alpha) const override;
+    
+    // Sprite-cached circles are composited rather than batched
+    bool pathStyle(const RenderContext& ctx, PathStyle& style) const override;
     
     void getAnimatableSize(float& w, float& h) const override {
         w = gridSize_.x;
@@ -125,9 +212,13 @@ public:
     void resetForAnimation() override {
         // Nothing special needed for circles
     }
+    
+    PixelRect getPixelBounds(const RenderContext& ctx) const override;
 
 private:
     float duration_;
+    
+    SpriteCache::Key spriteKey(float cellWidth, float cellHeight) const;
 };
 
 class Line : public Animatable {
@@ -136,7 +227,7 @@ public:
          float duration = 0.5f,
          float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 1.0f);
     
-    void setEndPos(const GridCoord& endPos) { endPos_ = endPos; }
+    void setEndPos(const GridCoord& endPos) { endPos_ = endPos; markDirty(); }
     GridCoord getEndPos() const { return endPos_; }
     
     // Waypoint management
@@ -159,7 +250,10 @@ public:
         moveTo({x, y});
     }
     
-    void draw(cairo_t* cr) override;
+    void record(DisplayList& list, const RenderContext& ctx, float alpha) const override;
+    
+    void saveState(StateBuffer& state) const override;
+    void restoreState(StateBuffer& state) override;
     
     void getAnimatableSize(float& w, float& h) const override {
         // For lines, size represents length and thickness
@@ -185,6 +279,7 @@ public:
                 waypoint.x = gridPos_.x + (waypoint.x - gridPos_.x) * scale;
                 waypoint.y = gridPos_.y + (waypoint.y - gridPos_.y) * scale;
             }
+            markDirty();
         }
         
         setStrokeWidth(h);
@@ -195,6 +290,15 @@ public:
         originalEndPos_ = endPos_;
         originalWaypoints_ = waypoints_;
     }
+    
+    PixelRect getPixelBounds(const RenderContext& ctx) const override;
+
+protected:
+    // Bounds of the polyline; offset is added to grid coordinates before scaling
+    PixelRect polylineBounds(float cellWidth, float cellHeight, float offset) const;
+    
+    // The stroked path, start through waypoints to end
+    virtual void recordPath(DisplayList& list, const RenderContext& ctx) const;
 
 private:
     GridCoord endPos_;
@@ -214,7 +318,12 @@ public:
     void setText(const std::string& content);
     void setFontSize(float size);
     float getFontSize() const { return fontSize_; }
-    void draw(cairo_t* cr) override;
+    void draw(cairo_t* cr, const RenderContext& ctx) override;
+    void prepareDraw(const RenderContext& ctx) override;
+    void record(DisplayList& list, const RenderContext& ctx, float alpha) const override;
+    
+    void saveState(StateBuffer& state) const override;
+    void restoreState(StateBuffer& state) override;
     
     void getAnimatableSize(float& w, float& h) const override {
         w = fontSize_;
@@ -229,12 +338,20 @@ public:
         // Store original font size for animation scaling
         originalFontSize_ = fontSize_;
     }
+    
+    PixelRect getPixelBounds(const RenderContext& ctx) const override;
 
 private:
     std::string content_;
     float fontSize_;
     float duration_;
     float originalFontSize_ = 24.0f;
+    GlyphRun run_;  // Shaped content_, refreshed by prepareDraw when text or size change
+    
+    // run_ if it is shaped for this frame, otherwise content_ shaped into
+    // scratch; const paths may run on tile workers and must not reshape run_
+    const GlyphRun& glyphRun(const RenderContext& ctx, GlyphRun& scratch) const;
+    SpriteCache::Key spriteKey(const RenderContext& ctx) const;
 };
 
 } // namespace banim
@@ -0,0 +1,36 @@
+#pragma once
+
+#define default_duration 0.5f
+
+namespace banim {
+
+class Animatable;
+class Scene;
+class TweenTrack;
+
+class Animation {
+  public:
+    virtual ~Animation() = default;
+    virtual bool update(float dt) = 0;
+
+    // Return to the not-yet-started state so a seeking Scene can play the
+    // animation again. Animations that keep progress between updates must
+    // override it.
+    virtual void reset() {}
+
+    // Called by the scene when it starts the animation, for animations that
+    // act on the scene itself (AddToScene, and groups holding one)
+    virtual void setScene(Scene* scene) {}
+
+    // The one object the animation changes, if it changes no other object
+    // and nothing shared between objects. Animations on different targets
+    // may be updated on different threads.
+    virtual Animatable* target() const { return nullptr; }
+
+    // Lower the animation into tweens on track, starting start seconds into
+    // the track. Returns false if it is not a plain tween; the track is then
+    // incomplete and must not be played.
+    virtual bool compile(TweenTrack& track, float start) const { return false; }
+};
+
+} // namespace banim
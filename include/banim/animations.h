@@ -1,29 +1,24 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
+#include "banim/animation.h"
 #include "banim/grid.h"
-
-#define default_duration 0.5f
+#include "banim/tween.h"
 
 namespace banim {
 
 class Scene;
-class Animatable;
-class Rectangle;
-class Line;
-
-class Animation {
-  public:
-    virtual ~Animation() = default;
-    virtual bool update(float dt) = 0;
-};
+class ThreadPool;
 
 class PopIn : public Animation {
   public:
     PopIn(std::shared_ptr<Animatable> animatable, float duration = default_duration);
 
     bool update(float dt) override;
+    void reset() override;
+    Animatable* target() const override;
 
   private:
     std::shared_ptr<Animatable> animatable_;
@@ -34,80 +29,53 @@ class PopIn : public Animation {
     float targetAlpha_ = 1.0f; // Store the target alpha value
 };
 
-class MoveTo : public Animation {
+class MoveTo : public Tween<prop::GridPos> {
   public:
     // Grid-based movement  
     MoveTo(std::shared_ptr<Animatable> target, const GridCoord& toGrid, float duration = default_duration);
     
-    bool update(float dt) override;
-
-  private:
-    std::shared_ptr<Animatable> target_;
-    GridCoord fromGrid_;
-    GridCoord toGrid_;
-    float duration_;
-    float elapsed_ = 0.0f;
-    bool initialized_ = false;
+    bool compile(TweenTrack& track, float start) const override;
 };
 
-class ResizeTo : public Animation {
+class ResizeTo : public Tween<prop::Size> {
   public:
     // Grid-based resizing
     ResizeTo(std::shared_ptr<Animatable> animatable, float gridW, float gridH, float duration = default_duration);
     
-    bool update(float dt) override;
-
-  private:
-    std::shared_ptr<Animatable> animatable_;
-    float startW_ = 0.0f, startH_ = 0.0f;
-    float targetW_, targetH_;
-    float duration_;
-    float elapsed_ = 0.0f;
-    bool initialized_ = false;
+    bool compile(TweenTrack& track, float start) const override;
 };
 
-class BorderTo : public Animation {
+class BorderTo : public Tween<prop::BorderRadius, ease::SmoothStep> {
   public:
     BorderTo(std::shared_ptr<Rectangle> rect, float targetRadius, float duration = default_duration);
-    bool update(float dt) override;
-
-  private:
-    std::shared_ptr<Rectangle> rect_;
-    float startRadius_ = 0.0f;
-    float targetRadius_;
-    float duration_;
-    float elapsed_ = 0.0f;
-    bool initialized_ = false;
+    bool compile(TweenTrack& track, float start) const override;
 };
 
 class Wait : public Animation {
   public:
     explicit Wait(float duration);
     bool update(float dt) override;
+    void reset() override;
+    bool compile(TweenTrack& track, float start) const override;
 
   private:
     float duration_;
     float elapsed_ = 0.0f;
 };
 
-class StrokeTo : public Animation {
+class StrokeTo : public Tween<prop::StrokeWidth> {
   public:
     StrokeTo(std::shared_ptr<Animatable> animatable, float targetStroke, float duration);
 
-    bool update(float dt) override;
-
-  private:
-    std::shared_ptr<Animatable> animatable_;
-    float startStroke_;
-    float targetStroke_;
-    float duration_;
-    float elapsed_ = 0.0f;
+    bool compile(TweenTrack& track, float start) const override;
 };
 
 class ClearWaypoints : public Animation {
   public:
     ClearWaypoints(std::shared_ptr<Line> line, float duration = default_duration);
     bool update(float dt) override;
+    void reset() override;
+    Animatable* target() const override;
 
   private:
     std::shared_ptr<Line> line_;
@@ -121,6 +89,8 @@ class AddWaypoint : public Animation {
   public:
     AddWaypoint(std::shared_ptr<Line> line, const GridCoord& newWaypoint, float duration = default_duration);
     bool update(float dt) override;
+    void reset() override;
+    Animatable* target() const override;
 
   private:
     std::shared_ptr<Line> line_;
@@ -136,6 +106,8 @@ class RemoveWaypoint : public Animation {
   public:
     RemoveWaypoint(std::shared_ptr<Line> line, int waypointIndex, float duration = default_duration);
     bool update(float dt) override;
+    void reset() override;
+    Animatable* target() const override;
 
   private:
     std::shared_ptr<Line> line_;
@@ -147,47 +119,38 @@ class RemoveWaypoint : public Animation {
     bool initialized_ = false;
 };
 
-class MoveWaypoint : public Animation {
+class MoveWaypoint : public Tween<prop::Waypoint> {
   public:
     MoveWaypoint(std::shared_ptr<Line> line, int waypointIndex, const GridCoord& targetPos, float duration = default_duration);
     
     bool update(float dt) override;
-
-  private:
-    std::shared_ptr<Line> line_;
-    int waypointIndex_;
-    GridCoord startPos_;
-    GridCoord targetPos_;
-    float duration_;
-    float elapsed_ = 0.0f;
-    bool initialized_ = false;
 };
 
-class MoveLineEnd : public Animation {
+class MoveLineEnd : public Tween<prop::LineEnd> {
   public:
     MoveLineEnd(std::shared_ptr<Line> line, const GridCoord& targetEndPos, float duration = default_duration);
-    
-    bool update(float dt) override;
-
-  private:
-    std::shared_ptr<Line> line_;
-    GridCoord startEndPos_;
-    GridCoord targetEndPos_;
-    float duration_;
-    float elapsed_ = 0.0f;
-    bool initialized_ = false;
 };
 
-class MoveLineStart : public Animation {
+class MoveLineStart : public Tween<prop::LineStart> {
   public:
     MoveLineStart(std::shared_ptr<Line> line, const GridCoord& targetStartPos, float duration = default_duration);
+};
+
+// Pan and zoom the scene's camera. Zoom changes geometrically, so equal
+// times give equal apparent scale steps in both directions.
+class CameraTo : public Animation {
+  public:
+    CameraTo(Scene& scene, const GridCoord& center, float zoom, float duration = default_duration);
     
     bool update(float dt) override;
+    void reset() override;
 
   private:
-    std::shared_ptr<Line> line_;
-    GridCoord startStartPos_;
-    GridCoord targetStartPos_;
+    Scene* scene_;
+    GridCoord fromCenter_;
+    GridCoord toCenter_;
+    float fromZoom_ = 1.0f;
+    float toZoom_;
     float duration_;
     float elapsed_ = 0.0f;
     bool initialized_ = false;
@@ -199,9 +162,10 @@ class AddToScene : public Animation {
     AddToScene(std::shared_ptr<Animatable> animatable, std::shared_ptr<Animation> spawnAnimation = nullptr);
     
     bool update(float dt) override;
+    void reset() override;
     
     // Set the scene this will add to (called by Scene internally)
-    void setScene(Scene* scene) { scene_ = scene; }
+    void setScene(Scene* scene) override { scene_ = scene; }
 
   private:
     std::shared_ptr<Animatable> animatable_;
@@ -220,9 +184,11 @@ class AnimationGroup : public Animation {
     void addAll(const std::vector<std::shared_ptr<Animation>>& animations);
     
     bool update(float dt) override;
+    void reset() override;
+    bool compile(TweenTrack& track, float start) const override;
     
     // Set scene for all AddToScene animations in the group
-    void setScene(Scene* scene);
+    void setScene(Scene* scene) override;
     
     // Check if the group is empty
     bool empty() const { return animations_.empty(); }
@@ -230,6 +196,74 @@ class AnimationGroup : public Animation {
 
   private:
     std::vector<std::shared_ptr<Animation>> animations_;
+    std::vector<Animatable*> targets_; // animations_[i]->target()
+    std::vector<uint32_t> running_; // Indices into animations_ not finished yet, in group order
+    Scene* scene_ = nullptr;        // For its update pool
+    
+    // Parallel update scratch, kept between updates
+    std::vector<uint32_t> bucketStart_; // Per bucket, into order_
+    std::vector<uint32_t> order_;       // Positions in running_, grouped by bucket
+    std::vector<uint8_t> finished_;     // Per position in running_
+    
+    void updateParallel(ThreadPool& pool, float dt);
+    // Targeted animations at running_[begin, end)
+    void updateSegment(ThreadPool& pool, size_t begin, size_t end, float dt);
+};
+
+// Animations on overlapping tracks. Each track starts at a time measured
+// from the start of the schedule and plays its animations one after
+// another, each gap seconds after the previous one ends. Starts not yet due
+// wait in a min-heap keyed on start time, so an update costs the running
+// animations plus the starts due, independent of the length of the schedule.
+class Schedule : public Animation {
+  public:
+    Schedule() = default;
+    
+    // Start animation on a new track, time seconds into the schedule.
+    // Returns the track for then.
+    int at(float time, std::shared_ptr<Animation> animation);
+    
+    // Play animation on track gap seconds after the track's last one ends
+    int then(int track, std::shared_ptr<Animation> animation, float gap = 0.0f);
+    
+    bool update(float dt) override;
+    void reset() override;
+    void setScene(Scene* scene) override;
+    bool compile(TweenTrack& track, float start) const override;
+    
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+
+  private:
+    struct Entry {
+        std::shared_ptr<Animation> animation;
+        float offset;         // Start time for a track's first entry, else gap
+        bool first;           // First entry of its track
+        int next = -1;        // Entry after this one on its track
+        float startedAt = 0;  // Schedule time it started
+    };
+    
+    struct Pending {
+        float start;
+        uint32_t entry;
+        bool operator>(const Pending& other) const { return start > other.start; }
+    };
+    
+    std::vector<Entry> entries_;
+    std::vector<int> tails_;         // Last entry of each track
+    std::vector<Pending> pending_;   // Min-heap on start
+    std::vector<uint32_t> active_;   // Running entries, unordered
+    std::vector<Pending> chained_;   // Successors of entries finished this update
+    float time_ = 0.0f;
+    bool started_ = false;
+    
+    void start();
+};
+
+// Start animations lag seconds apart, e.g. a staggered reveal
+class LaggedStart : public Schedule {
+  public:
+    LaggedStart(const std::vector<std::shared_ptr<Animation>>& animations, float lag);
 };
 
 } // namespace banim
\ No newline at end of file
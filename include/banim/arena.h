@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace banim {
+
+// Slab allocator for the objects and animations of one scene. Allocations
+// are carved off the current 64 KiB slab in order, so objects built one after
+// another sit next to each other in memory. Each slab counts its live
+// allocations and is recycled as a whole once the last of them is freed;
+// beginSegment starts a fresh slab so that the next group of objects (e.g.
+// the next timeline segment) does not share slabs with the previous one, and
+// the previous group's slabs go as soon as its owner drops it.
+// Large allocations go to the global heap.
+//
+// Use through ArenaAllocator and std::allocate_shared (see Scene::make).
+class Arena {
+  public:
+    static constexpr size_t kSlabSize = 64 * 1024;
+
+    Arena() = default;
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void deallocate(void* p, size_t bytes, size_t alignment);
+
+    void beginSegment();
+
+    // Slabs held, including the one kept for reuse
+    size_t slabCount() const;
+
+  private:
+    // Header at the start of each slab
+    struct Slab {
+        size_t live = 0;   // Allocations not freed yet
+        size_t used = 0;   // Bytes carved off, header included
+    };
+
+    static constexpr size_t kMaxSmall = kSlabSize / 8;
+
+    mutable std::mutex mutex_;
+    Slab* current_ = nullptr;
+    Slab* spare_ = nullptr;    // One empty slab kept for reuse
+    size_t slabCount_ = 0;
+
+    static bool small(size_t bytes, size_t alignment) { return bytes + alignment <= kMaxSmall; }
+    Slab* newSlab();
+    void release(Slab* slab);
+};
+
+// Standard allocator over an Arena. Copies share the arena and keep it alive,
+// so shared_ptrs made with it may outlive the scene that made them.
+template <typename T>
+class ArenaAllocator {
+  public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) : arena_(std::move(arena)) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t n) { arena_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena_; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena_; }
+
+  private:
+    template <typename U> friend class ArenaAllocator;
+    std::shared_ptr<Arena> arena_;
+};
+
+} // namespace banim
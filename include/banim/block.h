@@ -13,7 +13,15 @@ public:
     Block(const GridCoord& position, float gridWidth, float gridHeight, 
           const std::string& label = "");
     
-    void draw(cairo_t* cr) override;
+    void draw(cairo_t* cr, const RenderContext& ctx) override;
+    void prepareDraw(const RenderContext& ctx) override;
+    
+    // Block body at alpha, label and port dots as styled
+    void record(DisplayList& list, const RenderContext& ctx, float alpha) const override;
+    PixelRect getPixelBounds(const RenderContext& ctx) const override;
+    
+    void saveState(StateBuffer& state) const override;
+    void restoreState(StateBuffer& state) override;
     
     // IPortProvider implementation
     void addPort(PortDirection direction, const std::string& name) override;
@@ -34,7 +42,7 @@ public:
     void setLabel(const std::string& label);
     const std::string& getLabel() const { return label_; }
     void setLabelColor(float r, float g, float b, float a = 1.0f);
-    void setLabelSize(float size) { labelSize_ = size; }
+    void setLabelSize(float size) { labelSize_ = size; markDirty(); }
     
     // Override from Rectangle to update ports when size changes
     void setAnimatableSize(float w, float h) override {
@@ -56,6 +64,8 @@ private:
     std::string label_;
     float labelSize_;
     float labelR_, labelG_, labelB_, labelA_;
+    GlyphRun labelRun_;          // Shaped label_, refreshed by prepareDraw when text or size change
+    SpriteCache overlaySprite_;  // Label and port dots, composited over the faded body
     
     std::vector<Port> leftPorts_;
     std::vector<Port> rightPorts_;
@@ -66,6 +76,12 @@ private:
     virtual void updatePortsForDirection(std::vector<Port>& ports, PortDirection direction);
     std::vector<Port>& getPortVector(PortDirection direction);
     const std::vector<Port>& getPortVector(PortDirection direction) const;
+    // labelRun_ if it is shaped for this frame, otherwise label_ shaped into scratch
+    const GlyphRun& labelRun(const RenderContext& ctx, GlyphRun& scratch) const;
+    SpriteCache::Key spriteKey(const RenderContext& ctx) const;
+    SpriteCache::Key overlayKey(const RenderContext& ctx) const;
+    void recordOverlay(DisplayList& list, const RenderContext& ctx) const; // Label and port dots
+    bool detailed(const RenderContext& ctx) const; // Large enough on screen for label and ports
 };
 
 } // namespace banim
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+namespace banim {
+
+// Axis-aligned rectangle in pixel space
+struct PixelRect {
+    float x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    PixelRect() = default;
+    PixelRect(float x0, float y0, float x1, float y1) : x0(x0), y0(y0), x1(x1), y1(y1) {}
+
+    float width() const { return x1 - x0; }
+    float height() const { return y1 - y0; }
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    float area() const { return empty() ? 0.0f : width() * height(); }
+
+    bool intersects(const PixelRect& o) const {
+        return x0 < o.x1 && o.x0 < x1 && y0 < o.y1 && o.y0 < y1;
+    }
+    PixelRect inflated(float d) const { return {x0 - d, y0 - d, x1 + d, y1 + d}; }
+    PixelRect translated(float dx, float dy) const { return {x0 + dx, y0 + dy, x1 + dx, y1 + dy}; }
+    PixelRect united(const PixelRect& o) const;
+    PixelRect intersected(const PixelRect& o) const;
+
+    // Bounding box of a w x h rectangle at (x, y) rotated by angle about its center
+    static PixelRect rotated(float x, float y, float w, float h, float angle);
+};
+
+// Set of pixel rectangles that need repainting this frame. Nearby rects are
+// merged as they are added, and the region collapses to the whole surface
+// once repainting it piecewise would not be cheaper.
+class DamageRegion {
+public:
+    DamageRegion() = default;
+    DamageRegion(int width, int height) { reset(width, height); }
+
+    void reset(int width, int height);
+    void add(const PixelRect& rect);
+    void addFull();
+
+    bool empty() const { return rects_.empty(); }
+    bool isFull() const { return full_; }
+    bool intersects(const PixelRect& rect) const;
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Integer-aligned rectangles clipped to the surface
+    const std::vector<PixelRect>& rects() const { return rects_; }
+
+private:
+    std::vector<PixelRect> rects_;
+    int width_ = 0, height_ = 0;
+    bool full_ = false;
+
+    void mergeOverlapping();
+};
+
+} // namespace banim
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cairo/cairo.h>
+#include <cstdint>
+#include <vector>
+
+namespace banim {
+
+struct PathStyle;
+
+// Compact recording of one object's drawing: transforms, path construction,
+// style and paint operations with their arguments, in the order issued.
+// Objects record a list when they change and the Scene replays it each
+// frame, so draw logic runs once per visual change. Replaying only reads the
+// list, so tiles may replay it concurrently, and any cairo_t (an image tile,
+// a sprite, a PDF or SVG surface) can be the target.
+class DisplayList {
+public:
+    DisplayList() = default;
+    ~DisplayList();
+    DisplayList(const DisplayList&) = delete;
+    DisplayList& operator=(const DisplayList&) = delete;
+
+    void clear();
+    bool empty() const { return commands_.empty(); }
+
+    // Recording; each call stands for the cairo function of the same name
+    void save();
+    void restore();
+    void translate(double tx, double ty);
+    void rotate(double angle);
+    void scale(double sx, double sy);
+    void newPath();
+    void newSubPath();
+    void moveTo(double x, double y);
+    void lineTo(double x, double y);
+    void curveTo(double x1, double y1, double x2, double y2, double x3, double y3);
+    void arc(double xc, double yc, double radius, double angle1, double angle2);
+    void arcNegative(double xc, double yc, double radius, double angle1, double angle2);
+    void rectangle(double x, double y, double width, double height);
+    void closePath();
+    void setSourceRgba(double r, double g, double b, double a);
+    void setLineWidth(double width);
+    void fill();
+    void fillPreserve();
+    void stroke();
+    // Glyphs at (x, y) plus their own positions; keeps a reference to font
+    void showGlyphs(cairo_scaled_font_t* font, const cairo_glyph_t* glyphs, int count,
+                    double x, double y);
+
+    void replay(cairo_t* cr) const;
+
+    // Batching: true if the list builds one path and paints it with a
+    // single fill or stroke in a solid color, which style then describes
+    bool singlePaint(PathStyle& style) const;
+    // Replay only transforms and path construction, adding the path to cr
+    void appendPath(cairo_t* cr) const;
+
+private:
+    enum class Op : uint8_t {
+        Save, Restore, Translate, Rotate, Scale,
+        NewPath, NewSubPath, MoveTo, LineTo, CurveTo, Arc, ArcNegative, Rectangle, ClosePath,
+        SetSource, SetLineWidth, Fill, FillPreserve, Stroke, ShowGlyphs
+    };
+
+    struct Command {
+        Op op;
+        uint32_t first = 0, count = 0, font = 0; // ShowGlyphs: glyphs_ range, fonts_ index
+        float a[6] = {};
+    };
+
+    std::vector<Command> commands_;
+    std::vector<cairo_glyph_t> glyphs_;
+    std::vector<cairo_scaled_font_t*> fonts_; // Owned references
+
+    void push(Op op, double a0 = 0, double a1 = 0, double a2 = 0, double a3 = 0,
+              double a4 = 0, double a5 = 0);
+    static void replayPath(cairo_t* cr, const Command& c);
+};
+
+} // namespace banim
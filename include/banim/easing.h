@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cmath>
+
+namespace banim {
+
+// Easing functions for Tween. Each maps linear progress t in [0, 1] to eased
+// progress, with 0 at t = 0 and 1 at t = 1; Back, Elastic and Spring
+// overshoot in between. Any type with float operator()(float t) const works
+// as an easing, lambdas included.
+namespace ease {
+
+struct Linear {
+    constexpr float operator()(float t) const { return t; }
+};
+
+// 3t^2 - 2t^3
+struct SmoothStep {
+    constexpr float operator()(float t) const { return t * t * (3.0f - 2.0f * t); }
+};
+
+struct InQuad {
+    constexpr float operator()(float t) const { return t * t; }
+};
+
+struct OutQuad {
+    constexpr float operator()(float t) const { return 1.0f - (1.0f - t) * (1.0f - t); }
+};
+
+struct InOutQuad {
+    constexpr float operator()(float t) const {
+        float u = 2.0f - 2.0f * t;
+        return t < 0.5f ? 2.0f * t * t : 1.0f - u * u * 0.5f;
+    }
+};
+
+struct InCubic {
+    constexpr float operator()(float t) const { return t * t * t; }
+};
+
+struct OutCubic {
+    constexpr float operator()(float t) const {
+        float u = 1.0f - t;
+        return 1.0f - u * u * u;
+    }
+};
+
+struct InOutCubic {
+    constexpr float operator()(float t) const {
+        float u = 2.0f - 2.0f * t;
+        return t < 0.5f ? 4.0f * t * t * t : 1.0f - u * u * u * 0.5f;
+    }
+};
+
+struct InExpo {
+    float operator()(float t) const { return t <= 0.0f ? 0.0f : std::exp2(10.0f * t - 10.0f); }
+};
+
+struct OutExpo {
+    float operator()(float t) const { return t >= 1.0f ? 1.0f : 1.0f - std::exp2(-10.0f * t); }
+};
+
+struct InOutExpo {
+    float operator()(float t) const {
+        if (t <= 0.0f) return 0.0f;
+        if (t >= 1.0f) return 1.0f;
+        return t < 0.5f ? std::exp2(20.0f * t - 10.0f) * 0.5f
+                        : 1.0f - std::exp2(10.0f - 20.0f * t) * 0.5f;
+    }
+};
+
+// Pulls back by about 10% before moving on
+struct InBack {
+    constexpr float operator()(float t) const { return t * t * (kC3 * t - kC1); }
+    static constexpr float kC1 = 1.70158f, kC3 = kC1 + 1.0f;
+};
+
+struct OutBack {
+    constexpr float operator()(float t) const {
+        float u = t - 1.0f;
+        return 1.0f + u * u * (InBack::kC3 * u + InBack::kC1);
+    }
+};
+
+struct InOutBack {
+    constexpr float operator()(float t) const {
+        if (t < 0.5f) {
+            float u = 2.0f * t;
+            return u * u * ((kC2 + 1.0f) * u - kC2) * 0.5f;
+        }
+        float u = 2.0f * t - 2.0f;
+        return (u * u * ((kC2 + 1.0f) * u + kC2) + 2.0f) * 0.5f;
+    }
+    static constexpr float kC2 = InBack::kC1 * 1.525f;
+};
+
+struct InElastic {
+    float operator()(float t) const {
+        if (t <= 0.0f) return 0.0f;
+        if (t >= 1.0f) return 1.0f;
+        return -std::exp2(10.0f * t - 10.0f) * std::sin((10.0f * t - 10.75f) * kC4);
+    }
+    static constexpr float kC4 = 2.0943951f; // 2 pi / 3
+};
+
+struct OutElastic {
+    float operator()(float t) const {
+        if (t <= 0.0f) return 0.0f;
+        if (t >= 1.0f) return 1.0f;
+        return std::exp2(-10.0f * t) * std::sin((10.0f * t - 0.75f) * InElastic::kC4) + 1.0f;
+    }
+};
+
+// Damped spring released at t = 0: swings around the end value
+// `oscillations` times while its amplitude decays by exp(-damping * t)
+class Spring {
+  public:
+    constexpr Spring(float oscillations = 2.0f, float damping = 6.0f)
+        : frequency_(oscillations * 6.2831853f), damping_(damping) {}
+
+    float operator()(float t) const {
+        if (t >= 1.0f) return 1.0f;
+        return 1.0f - std::exp(-damping_ * t) * std::cos(frequency_ * t);
+    }
+
+  private:
+    float frequency_;
+    float damping_;
+};
+
+// CSS-style cubic Bézier from (0, 0) to (1, 1) through control points
+// (x1, y1) and (x2, y2), with x1 and x2 in [0, 1]
+class CubicBezier {
+  public:
+    constexpr CubicBezier(float x1, float y1, float x2, float y2)
+        : cx_(3.0f * x1), bx_(3.0f * (x2 - x1) - 3.0f * x1), ax_(1.0f + 3.0f * (x1 - x2)),
+          cy_(3.0f * y1), by_(3.0f * (y2 - y1) - 3.0f * y1), ay_(1.0f + 3.0f * (y1 - y2)) {}
+
+    float operator()(float t) const {
+        if (t <= 0.0f) return 0.0f;
+        if (t >= 1.0f) return 1.0f;
+        return sample(ay_, by_, cy_, solve(t));
+    }
+
+  private:
+    // Polynomial coefficients of x(s) and y(s) = ((a s + b) s + c) s
+    float cx_, bx_, ax_;
+    float cy_, by_, ay_;
+
+    static float sample(float a, float b, float c, float s) { return ((a * s + b) * s + c) * s; }
+
+    // Curve parameter s with x(s) = x: Newton steps, then bisection if the
+    // slope is too flat for them to converge
+    float solve(float x) const {
+        constexpr float kEpsilon = 1e-6f;
+        float s = x;
+        for (int i = 0; i < 8; ++i) {
+            float error = sample(ax_, bx_, cx_, s) - x;
+            if (std::fabs(error) < kEpsilon) return s;
+            float slope = (3.0f * ax_ * s + 2.0f * bx_) * s + cx_;
+            if (std::fabs(slope) < kEpsilon) break;
+            s -= error / slope;
+        }
+        float lo = 0.0f, hi = 1.0f;
+        s = x;
+        for (int i = 0; i < 32; ++i) {
+            float sx = sample(ax_, bx_, cx_, s);
+            if (std::fabs(sx - x) < kEpsilon) break;
+            if (sx < x) lo = s; else hi = s;
+            s = (lo + hi) * 0.5f;
+        }
+        return s;
+    }
+};
+
+} // namespace ease
+
+} // namespace banim
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "banim/damage.h"
+#include <cairo/cairo.h>
+#include <cstddef>
+#include <vector>
+
+namespace banim {
+
+// Stages of one interactive frame, in the order they run
+enum class FramePhase { Update, Rasterize, Upload, Swap, Count };
+
+constexpr int kFramePhaseCount = static_cast<int>(FramePhase::Count);
+
+const char *framePhaseName(FramePhase phase);
+
+// Wall-clock seconds spent in each phase of one frame
+struct FrameTiming {
+  double seconds[kFramePhaseCount] = {};
+
+  double &operator[](FramePhase phase) { return seconds[static_cast<int>(phase)]; }
+  double operator[](FramePhase phase) const { return seconds[static_cast<int>(phase)]; }
+  double total() const;
+};
+
+// Fixed-size ring buffer of the most recent frame timings
+class FrameStats {
+public:
+  explicit FrameStats(size_t capacity = 240);
+
+  void push(const FrameTiming &timing);
+  void clear();
+  size_t size() const { return count_; }
+  size_t capacity() const { return ring_.size(); }
+
+  // p-th percentile (0-100) over the buffered frames, in seconds; 0 if empty
+  double percentile(FramePhase phase, double p) const;
+  double totalPercentile(double p) const;
+
+private:
+  std::vector<FrameTiming> ring_;
+  size_t next_ = 0;
+  size_t count_ = 0;
+  mutable std::vector<double> scratch_; // Sort buffer for percentiles
+
+  template <typename Fn> double percentileOf(double p, Fn value) const;
+};
+
+// Dynamic resolution controller. Picks the scale frames are rasterized at
+// from recent rasterize times: one step down when they overrun the budget,
+// one step up when the larger size would still fit comfortably.
+class ResolutionScaler {
+public:
+  explicit ResolutionScaler(double budgetSeconds = 1.0 / 60.0, float minScale = 0.5f);
+
+  void setBudget(double seconds) { budget_ = seconds; }
+  void setMinScale(float scale) { minScale_ = scale; }
+  float scale() const { return scale_; }
+
+  // Record the rasterize time of a frame drawn at scale(); returns the
+  // scale for the next frame
+  float update(double rasterizeSeconds);
+
+  // Back to full resolution, e.g. once the scene is idle
+  void reset();
+
+private:
+  double budget_;
+  float minScale_;
+  float scale_ = 1.0f;
+  double average_ = 0.0; // Smoothed rasterize time at scale_
+  int cooldown_ = 0;     // Frames left before the next change
+};
+
+// Draw a small table of p50/p99 per phase with its top-left corner at (x, y).
+// Returns the pixel area it covered.
+PixelRect drawFrameStatsHud(cairo_t *cr, const FrameStats &stats, float x, float y);
+
+} // namespace banim
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "banim/scene.h"
+#include "banim/surface.h"
+#include <cairo/cairo.h>
+#include <functional>
+#include <thread>
+
+namespace banim {
+
+// Offline rendering without a window: no GLFW, GLEW or texture uploads,
+// only the Cairo surface the scene is rasterized into.
+struct HeadlessOptions {
+  int width = 1920;
+  int height = 1080;
+  int fps = 60;
+  int maxFrames = 0; // 0 = run until the timeline drains
+
+  // renderHeadless only: threads rasterizing each frame as tiles
+  // (1 = single-threaded, 0 = std::thread::hardware_concurrency()). Unless
+  // the scene has its own update pool, they also run its large animation
+  // groups (Scene::setUpdatePool).
+  int tileThreads = 1;
+  int tileSize = 256;
+};
+
+// Receives each finished frame in order. The surface is only valid for the
+// duration of the call and is reused for the next frame.
+using FrameSink = std::function<void(int frameIndex, cairo_surface_t *frame)>;
+
+// Step the scene with an exact dt of 1/fps and hand every rasterized frame
+// to sink until the timeline drains. Returns the number of frames rendered.
+int renderHeadless(Scene &scene, const HeadlessOptions &opt, const FrameSink &sink);
+
+// Builds a fresh scene: objects, timeline and grid config. It is called once
+// per worker (on the calling thread), so it must create new Animatables on
+// every call rather than share them between scenes.
+using SceneBuilder = std::function<void(Scene &scene)>;
+
+struct ParallelOptions : HeadlessOptions {
+  int threads = 0;       // 0 = std::thread::hardware_concurrency()
+  int chunkFrames = 16;  // Contiguous frames rendered per job
+  int chunksInFlight = 0; // Buffered chunks ahead of the sink, 0 = 2 * threads
+};
+
+// Same output as renderHeadless, rendered on several threads. The timeline is
+// split into contiguous chunks of frames; each worker owns its own scene and
+// surface, skips ahead (update only, no rasterization) to each chunk it owns,
+// renders it into a buffer, and the calling thread hands frames to sink in
+// order. Returns the number of frames rendered.
+int renderParallel(const SceneBuilder &build, const ParallelOptions &opt,
+                   const FrameSink &sink);
+
+} // namespace banim
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "banim/frame_stats.h"
 #include "banim/scene.h"
+#include "banim/surface.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <cairo/cairo.h>
+#include <memory>
+#include <vector>
 
 namespace banim {
 
@@ -12,6 +16,17 @@ struct InitOptions {
   int height;
   const char *title;
   bool vsync;
+  bool showStats = false; // Frame timing HUD (toggle with H)
+  // Rasterize straight into mapped GL buffers when the driver supports
+  // persistent mapping (GL_ARB_buffer_storage); otherwise frames are copied
+  bool zeroCopyUpload = true;
+  // Rasterize busy frames below window resolution to hold the frame rate
+  // and let the GL scale them up; idle frames are always full resolution
+  bool dynamicResolution = false;
+  float minResolutionScale = 0.5f;
+  // Seconds of playback between the timeline checkpoints run() has the
+  // scene keep for seeking (see Scene::seek)
+  float checkpointInterval = 2.0f;
 };
 
 class GLContext {
@@ -29,30 +44,61 @@ private:
   int w_, h_;
 };
 
-class CairoSurface {
-public:
-  CairoSurface(int w, int h);
-  ~CairoSurface();
-  void recreate(int w, int h);
-  cairo_t *context() const { return cr_; }
-  cairo_surface_t *surface() const { return surf_; }
-
-private:
-  cairo_surface_t *surf_ = nullptr;
-  cairo_t *cr_ = nullptr;
-};
-
 class Texture2D {
 public:
   Texture2D(int w, int h);
   ~Texture2D();
   void resize(int w, int h);
-  void upload(const cairo_surface_t *surf);
+  // Upload the whole surface, or only the damaged rectangles when given
+  void upload(const cairo_surface_t *surf, const DamageRegion *damage = nullptr);
+  // Same from pixels already in pbo, rows stride bytes apart; no CPU copy
+  void uploadFrom(GLuint pbo, int stride, const DamageRegion *damage = nullptr);
   GLuint id() const { return tex_; }
 
 private:
   GLuint tex_ = 0, pbo_ = 0;
   int tex_w_, tex_h_;
+  bool needsFullUpload_ = true; // Texture contents undefined after (re)allocation
+
+  // glTexSubImage2D from the bound unpack buffer
+  void transfer(int stride, bool partial, const DamageRegion *damage);
+};
+
+// Ring of persistently mapped pixel-unpack buffers, each wrapped in a
+// CairoSurface, so frames are rasterized directly into memory the GL uploads
+// from. A fence per buffer keeps the CPU from drawing into one the GL still
+// reads; with three buffers that wait practically never happens. Each buffer
+// remembers the damage of frames drawn into the others, so only regions it
+// is behind on are repainted.
+class PixelBufferRing {
+public:
+  // Needs GL 4.4 or GL_ARB_buffer_storage (Mesa's llvmpipe has it)
+  static bool supported();
+
+  PixelBufferRing(int w, int h, int count = 3);
+  ~PixelBufferRing();
+  void resize(int w, int h);
+
+  // Surface for the next frame. Regions where it lags the newest frame are
+  // invalidated on scene, so rasterizeFrame brings it fully up to date.
+  CairoSurface &acquire(Scene &scene);
+  // Upload the damaged part of the acquired surface into tex and fence it
+  void submit(Texture2D &tex, const DamageRegion &damage);
+
+private:
+  struct Slot {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    std::unique_ptr<CairoSurface> surface;
+    DamageRegion stale; // Scene pixels drawn in other slots since this one was drawn
+  };
+
+  std::vector<Slot> slots_;
+  int w_ = 0, h_ = 0, stride_ = 0;
+  int current_ = -1;
+
+  void allocate(int w, int h);
+  void release();
 };
 
 class Shader {
@@ -68,12 +114,30 @@ private:
 };
 
 bool init(const InitOptions &opt);
-void renderFrame(Scene &scene);
+// Rasterize, upload and present one frame; timing receives the rasterize,
+// upload and swap durations when given
+void renderFrame(Scene &scene, FrameTiming *timing = nullptr);
 void cleanup();
+
+// Drive the scene until the window closes, pacing frames to fps. With a fixed
+// timestep the scene advances in exact 1/fps steps from an accumulator, with
+// at most a few catch-up steps per frame after a stall; otherwise it advances
+// by the measured frame time.
+//
+// Playback keys: Space pauses, Left/Right seek 1 s (10 s with Shift), Comma
+// and Period step one frame back or forward (and pause), Home returns to the
+// start, Up/Down double or halve the speed and 0 resets it.
 void run(Scene& scene, bool fixedTimestep = true, int fps = 60);
 
+// Timings of the most recent frames driven by run()
+const FrameStats &frameStats();
+void showFrameStats(bool show);
+
+// Scale the last presented frame was rasterized at (1 = window resolution)
+float resolutionScale();
+
 extern GLContext *g_ctx;
-extern Scene *g_currentScene;  // For keyboard callbacks
+extern Scene *g_currentScene; // Scene driven by run(), for keyboard callbacks
 
 
 } // namespace banim
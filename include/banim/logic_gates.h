@@ -23,7 +23,13 @@ public:
     LogicGate(GateType type, PortDirection facing, const GridCoord& position, 
               float gridWidth = 1.0f, float gridHeight = 1.0f);
     
-    void draw(cairo_t* cr) override;
+    void draw(cairo_t* cr, const RenderContext& ctx) override;
+    void prepareDraw(const RenderContext& ctx) override;
+    void record(DisplayList& list, const RenderContext& ctx, float alpha) const override;
+    PixelRect getPixelBounds(const RenderContext& ctx) const override;
+    
+    void saveState(StateBuffer& state) const override;
+    void restoreState(StateBuffer& state) override;
     
     // IPortProvider implementation
     void addPort(PortDirection direction, const std::string& name) override;
@@ -65,7 +71,7 @@ public:
     // Set gate colors
     void setGateColor(float r, float g, float b, float a = 1.0f);
     void setSymbolColor(float r, float g, float b, float a = 1.0f);
-    LogicGate& setFilled(bool filled) override { filled_ = filled; return *this; }
+    LogicGate& setFilled(bool filled) override { Rectangle::setFilled(filled); return *this; }
 
 private:
     GateType gateType_;
@@ -74,7 +80,6 @@ private:
     // Colors for gate drawing
     float gateR_ = 0.9f, gateG_ = 0.9f, gateB_ = 0.9f, gateA_ = 1.0f;
     float symbolR_ = 0.0f, symbolG_ = 0.0f, symbolB_ = 0.0f, symbolA_ = 1.0f;
-    bool filled_ = true;
     
     // Port storage
     std::vector<Port> leftPorts_;
@@ -89,11 +94,11 @@ private:
     const std::vector<Port>& getPortVector(PortDirection direction) const;
     
     // Individual gate shape drawing methods
-    void drawAndGate(cairo_t* cr, float width, float height);
-    void drawOrGate(cairo_t* cr, float width, float height);
-    void drawXorGate(cairo_t* cr, float width, float height);
-    void drawNotGate(cairo_t* cr, float width, float height);
-    void drawInversionBubble(cairo_t* cr, float width, float height);
+    void drawAndGate(DisplayList& list, float width, float height) const;
+    void drawOrGate(DisplayList& list, float width, float height) const;
+    void drawXorGate(DisplayList& list, float width, float height) const;
+    void drawNotGate(DisplayList& list, float width, float height, float alpha) const;
+    void drawInversionBubble(DisplayList& list, float width, float height, float alpha) const;
     
     std::string getGateSymbol() const;
 };
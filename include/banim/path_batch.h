@@ -0,0 +1,64 @@
+#pragma once
+
+#include "banim/damage.h"
+#include "banim/render_context.h"
+#include <cairo/cairo.h>
+#include <vector>
+
+namespace banim {
+
+class Animatable;
+
+// Solid style of an object drawn as a single fill or stroke
+struct PathStyle {
+    float r = 0, g = 0, b = 0, a = 1;
+    float lineWidth = 0; // Stroke width, unused for fills
+    bool fill = true;
+
+    bool operator==(const PathStyle& o) const {
+        return r == o.r && g == o.g && b == o.b && a == o.a && fill == o.fill &&
+               (fill || lineWidth == o.lineWidth);
+    }
+};
+
+// Draws objects in z-order, merging the geometry of objects that share a
+// PathStyle into one path that is filled or stroked once. A batch stays open
+// across other objects as long as none of them overlaps it; an object that
+// does flushes the batches below it first, so the result matches drawing one
+// by one. Translucent styles are not merged, since overlapping parts of one
+// path are painted only once.
+class PathBatcher {
+public:
+    PathBatcher(cairo_t* cr, const RenderContext& ctx) : cr_(cr), ctx_(ctx) {}
+    ~PathBatcher() { flush(); }
+
+    // Draw object, whose target-space bounds are bounds (anything() when unknown)
+    void draw(Animatable& object, const PixelRect& bounds);
+
+    // Fill or stroke every open batch
+    void flush();
+
+    // Bounds that overlap every other object
+    static PixelRect anything();
+
+private:
+    struct Batch {
+        PathStyle style;
+        std::vector<PixelRect> area; // A few boxes covering the objects
+        std::vector<const Animatable*> objects;
+
+        bool overlaps(const PixelRect& bounds) const;
+        void cover(const PixelRect& bounds);
+    };
+
+    cairo_t* cr_;
+    const RenderContext& ctx_;
+    std::vector<Batch> open_; // Pairwise non-overlapping, so flush order is free
+
+    // Submit open batches overlapping bounds, except open_[keep]; returns
+    // the new index of that batch (-1 if keep is -1)
+    int flushOverlapping(const PixelRect& bounds, int keep);
+    void submit(const Batch& batch);
+};
+
+} // namespace banim
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "banim/grid.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <memory>
@@ -23,11 +24,34 @@ struct Port {
         : direction(dir), name(portName) {}
 };
 
+class IPortProvider;
+
+// Told when a port provider it listens to changes
+class IPortListener {
+public:
+    virtual ~IPortListener() = default;
+    
+    // provider moved, resized or changed its ports. Called from the setter
+    // that made the change, which may run on an update thread.
+    virtual void portsChanged(IPortProvider& provider) = 0;
+};
+
 // Common interface for objects that have ports (blocks, logic gates, etc.)
 class IPortProvider {
 public:
     virtual ~IPortProvider() = default;
     
+    // Change notification. A listener must remove itself before it is
+    // destroyed; adding one twice has no effect.
+    void addPortListener(IPortListener* listener) {
+        if (std::find(portListeners_.begin(), portListeners_.end(), listener) == portListeners_.end())
+            portListeners_.push_back(listener);
+    }
+    void removePortListener(IPortListener* listener) {
+        portListeners_.erase(std::remove(portListeners_.begin(), portListeners_.end(), listener),
+                             portListeners_.end());
+    }
+    
     // Port management
     virtual void addPort(PortDirection direction, const std::string& name) = 0;
     virtual void removePort(PortDirection direction, const std::string& name) = 0;
@@ -45,6 +69,22 @@ public:
     
     // Position access
     virtual GridCoord getGridPos() const = 0;
+
+protected:
+    IPortProvider() = default;
+    
+    // Listeners follow the original object: a copy starts with none, and
+    // assignment keeps the target's own
+    IPortProvider(const IPortProvider&) {}
+    IPortProvider& operator=(const IPortProvider&) { return *this; }
+    
+    // Implementations call this whenever port positions may have changed
+    void notifyPortsChanged() {
+        for (IPortListener* listener : portListeners_) listener->portsChanged(*this);
+    }
+
+private:
+    std::vector<IPortListener*> portListeners_;
 };
 
 } // namespace banim
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cairo/cairo.h>
+#include <cmath>
+
+namespace banim {
+
+// Per-frame quality settings, applied to every context the frame draws into
+// (the target and any offscreen caches)
+struct RenderQuality {
+    cairo_antialias_t antialias = CAIRO_ANTIALIAS_DEFAULT;
+
+    // Level of detail: objects whose on-screen size is below this many pixels
+    // are drawn simplified (gates as plain boxes, blocks without label and
+    // port dots, wires without short segments). 0 disables it.
+    float detailMinPixels = 12.0f;
+};
+
+// What an Animatable needs to know about the frame it is drawn into: the
+// target size, the grid-to-pixel transform and the quality settings. Built
+// once per frame by the Scene and passed to every draw call, so independent
+// scenes and surfaces can be rendered at the same time.
+//
+// Objects draw in scene pixels (grid coordinate * cell size, zoom included);
+// the Scene translates the target by (originX, originY) to place the camera.
+struct RenderContext {
+    int width = 0, height = 0;           // Target surface in pixels
+    float cellWidth = 0, cellHeight = 0; // One grid cell in pixels, zoom included
+    float zoom = 1.0f;                   // Camera zoom; text scales with it
+    float originX = 0, originY = 0;      // Target pixel of grid (0, 0), whole pixels
+    RenderQuality quality;
+
+    RenderContext() = default;
+    RenderContext(int width, int height, int cols, int rows, const RenderQuality& quality = {})
+        : width(width), height(height),
+          cellWidth(static_cast<float>(width) / static_cast<float>(cols)),
+          cellHeight(static_cast<float>(height) / static_cast<float>(rows)),
+          quality(quality) {}
+
+    // Same target viewed through a camera centered on grid point (centerX,
+    // centerY) at the given zoom (1 = the whole grid fills the target)
+    RenderContext(int width, int height, int cols, int rows, float centerX, float centerY,
+                  float zoom, const RenderQuality& quality = {})
+        : RenderContext(width, height, cols, rows, quality) {
+        this->zoom = zoom;
+        cellWidth *= zoom;
+        cellHeight *= zoom;
+        originX = std::round(static_cast<float>(width) * 0.5f - centerX * cellWidth);
+        originY = std::round(static_cast<float>(height) * 0.5f - centerY * cellHeight);
+    }
+
+    // True if something spanning this many pixels on screen gets full detail
+    bool detailed(float pixels) const { return pixels >= quality.detailMinPixels; }
+};
+
+} // namespace banim
@@ -2,15 +2,22 @@
 
 #include <cairo/cairo.h>
 #include <memory>
+#include <unordered_set>
 #include <vector>
-#include <queue>
 #include <variant>
+#include "banim/arena.h"
 #include "banim/grid.h"
+#include "banim/damage.h"
+#include "banim/render_context.h"
+#include "banim/spatial_index.h"
+#include "banim/state_buffer.h"
+#include "banim/surface.h"
 
 namespace banim {
 
 class Animatable;
 class Animation;
+class ThreadPool;
 class AnimationGroup;
 class AddToScene;
 
@@ -38,29 +45,72 @@ struct GridConfig {
         : cols(cols), rows(rows), displayGrid(display) {}
 };
 
+// View onto the grid. center is a grid coordinate (cell-centered, like
+// object positions); zoom 1 fits the whole grid to the surface.
+struct Camera {
+    GridCoord center;
+    float zoom = 1.0f;
+    
+    Camera() = default;
+    Camera(const GridCoord& center, float zoom = 1.0f) : center(center), zoom(zoom) {}
+};
+
 class Scene {
   public:
     Scene() = default;
     Scene(const GridConfig& gridConfig) : gridConfig_(gridConfig) {}
     
     // Grid management
-    void setGridConfig(const GridConfig& config) { gridConfig_ = config; }
+    void setGridConfig(const GridConfig& config) { gridConfig_ = config; fullDamage_ = true; }
     const GridConfig& getGridConfig() const { return gridConfig_; }
-    void displayGrid(bool show) { gridConfig_.displayGrid = show; }
+    void displayGrid(bool show) { gridConfig_.displayGrid = show; fullDamage_ = true; }
     bool isGridDisplayed() const { return gridConfig_.displayGrid; }
     
-    // Convert grid coordinates to pixel coordinates (for rendering)
+    // Quality settings applied to every frame; changing them repaints everything
+    void setRenderQuality(const RenderQuality& quality) { quality_ = quality; fullDamage_ = true; }
+    const RenderQuality& getRenderQuality() const { return quality_; }
+    
+    // Camera zoom and pan; moving it repaints everything. While it keeps
+    // moving, frames draw every visible object instead of rebaking the static
+    // layer each time. Until a camera is set it stays centered on the grid at
+    // zoom 1.
+    void setCamera(const Camera& camera) {
+        camera_ = camera;
+        cameraSet_ = true;
+        cameraMoved_ = true;
+        fullDamage_ = true;
+    }
+    Camera getCamera() const;
+    
+    // Frame parameters for drawing this scene into a width x height target
+    RenderContext renderContext(int width, int height) const;
+    
+    // Convert grid coordinates to pixel coordinates on the surface the scene
+    // was last rendered to (the window before the first frame), camera included
     std::pair<float, float> gridToPixel(const GridCoord& coord) const;
     std::pair<float, float> gridToPixel(float gridX, float gridY) const;
     
-    // Get grid cell size in pixels
+    // Get grid cell size in pixels, zoom included
     std::pair<float, float> getGridCellSize() const;
     
+    // Construct an object or animation in the scene's arena, so those built
+    // one after another share memory slabs. Use like std::make_shared:
+    // scene.make<Block>(GridCoord(2, 2), 2.0f, 1.0f, "A")
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena_), std::forward<Args>(args)...);
+    }
+    const Arena& arena() const { return *arena_; }
+    
     // Add animatable objects
     void add(std::shared_ptr<Animatable> animatable);
     void add(std::shared_ptr<Animatable> animatable, std::shared_ptr<Animation> animation);
     
-    // Clear all animatable objects from the scene
+    // Clear all animatable objects from the scene. Objects made after this
+    // call go to fresh arena slabs. A seekable scene keeps the objects and
+    // actions before the clear for seeking back; an unseekable one drops
+    // them when the clear plays, which frees their slabs once nothing else
+    // refers to them.
     void clear();
     
     // Animation playback
@@ -75,20 +125,160 @@ class Scene {
         playGroup({std::forward<Args>(animations)...});
     }
     
-    void renderScene(cairo_t *cr);
+    // Staggered playback - each animation starts lag seconds after the
+    // previous one, overlapping it (see LaggedStart; Schedule for more)
+    void playLagged(const std::vector<std::shared_ptr<Animation>>& animations, float lag);
+    
+    void renderScene(cairo_t *cr, const RenderContext& ctx);
     void update(float dt);
+    
+    // Let update run large animation groups and tween tracks on pool
+    // (nullptr = calling thread only). Animations on different objects run
+    // concurrently, each object's in order on one thread; nested groups and
+    // schedules run alone between them, so results match a serial update.
+    // The pool must not run other jobs during update.
+    void setUpdatePool(ThreadPool* pool) { updatePool_ = pool; }
+    ThreadPool* getUpdatePool() const { return updatePool_; }
+    
+    // renderScene split in phases so one frame can be drawn by several
+    // threads. prepareRender runs on the rendering thread and refreshes every
+    // cache the frame reads (static layer, grid, object sprites and text) for
+    // objects overlapping clip. drawPrepared only reads the scene, so it may
+    // run concurrently on disjoint regions of the target, each culling against
+    // its own clip. finishRender ends the frame.
+    void prepareRender(const RenderContext& ctx, const PixelRect& clip);
+    void drawPrepared(cairo_t *cr, const RenderContext& ctx) const;
+    void finishRender();
+    
+    // Collect the pixel regions that changed since the last collected frame
+    // on a width x height surface: the old and new bounds of every object
+    // whose appearance changed. Scene-wide changes (grid, clear, resize)
+    // damage the whole surface. The next renderScene call skips objects that
+    // lie outside its clip.
+    void collectDamage(int width, int height, DamageRegion& damage);
+    
+    // Force the next collectDamage to report the whole surface, or just rect
+    // (e.g. pixels an overlay drew over the scene)
+    void invalidate() { fullDamage_ = true; }
+    void invalidate(const PixelRect& rect) { pendingDamage_.push_back(rect); }
+    
+    // Static layer caching: objects that have not changed for a while are
+    // rasterized once into an offscreen layer (together with the grid), and
+    // each frame blits that layer and draws only the live objects on top.
+    // Requires collectDamage to run before renderScene, as rasterizeFrame does.
+    void setStaticLayerCaching(bool enable) { staticLayerEnabled_ = enable; staticLayerValid_ = false; }
+    bool isStaticLayerCaching() const { return staticLayerEnabled_; }
     void wait(float duration);
     
+    // True once the timeline is drained and no animation is running
+    bool isFinished() const { return !currentAnimation_ && timelineIndex_ >= timeline_.size(); }
+    
+    // Seconds of timeline played: the dt passed to update since the start,
+    // or since the time last sought to
+    float getTime() const { return time_; }
+    
+    // Seeking. The scene checkpoints the properties of every object it has
+    // seen at the start of the timeline and then, every interval seconds of
+    // playback, at the next point where one timeline action ends and the
+    // next begins (0 = only at the start). seek restores the latest
+    // checkpoint at or before time, or continues from the current position
+    // if that is closer, and fast-forwards with update steps of step seconds
+    // without rendering. Returns the time reached: the nearest whole step to
+    // time, or the end of the timeline if that comes first.
+    void setCheckpointInterval(float seconds) { checkpointInterval_ = seconds; }
+    float getCheckpointInterval() const { return checkpointInterval_; }
+    float seek(float time, float step = 1.0f / 60.0f);
+    
+    // An unseekable scene keeps no checkpoints or object history, and seek
+    // only fast-forwards from the current time. For one-pass rendering, so
+    // that memory from before a clear is released. Seekable by default.
+    void setSeekable(bool seekable);
+    bool isSeekable() const { return seekable_; }
+    
     // Method for AddToScene animation to add animatables directly
     void addAnimatable(std::shared_ptr<Animatable> animatable);
 
   private:
+    // Per-object damage bookkeeping, parallel to animatables_
+    struct DrawState {
+        PixelRect bounds;       // Bounds at the last collected frame
+        bool hasBounds = false;
+        int idleFrames = 0;     // Collected frames since the object last changed
+        bool live = false;      // Drawn every frame instead of from the static layer
+        bool inLayer = false;   // Baked into the static layer at layerBounds
+        PixelRect layerBounds;
+    };
+    
+    // Scene state at a timeline action boundary
+    struct Checkpoint {
+        float time = 0;
+        size_t timelineIndex = 0;  // Next action to start
+        size_t trackedCount = 0;   // Prefix of tracked_ whose properties are in state
+        std::vector<std::shared_ptr<Animatable>> animatables;
+        StateBuffer state;
+        Camera camera;
+        bool cameraSet = false;
+    };
+    
+    // Every object the timeline has added, in the order first seen. Objects
+    // first seen after the start checkpoint keep their properties from that
+    // moment, for seeking back to before they existed.
+    struct TrackedObject {
+        std::shared_ptr<Animatable> animatable;
+        std::unique_ptr<StateBuffer> initial;
+    };
+    
+    std::shared_ptr<Arena> arena_ = std::make_shared<Arena>();
+    ThreadPool* updatePool_ = nullptr;
     std::vector<std::shared_ptr<Animatable>> animatables_;
-    std::queue<TimelineAction> timeline_;
-    std::shared_ptr<Animation> currentAnimation_ = nullptr;
+    std::vector<DrawState> drawStates_;
+    SpatialIndex spatialIndex_;   // Indices into animatables_, keyed on DrawState::bounds
+    std::vector<TimelineAction> timeline_;
+    size_t timelineIndex_ = 0;    // Next action to start
+    Animation* currentAnimation_ = nullptr; // Owned by timeline_
+    float time_ = 0;
+    float checkpointInterval_ = 0;
+    bool seekable_ = true;
+    std::vector<Checkpoint> checkpoints_; // In time order
+    std::vector<TrackedObject> tracked_;
+    std::unordered_set<const Animatable*> trackedSet_;
     GridConfig gridConfig_;
+    RenderQuality quality_;
+    Camera camera_;
+    bool cameraSet_ = false;
+    bool cameraMoved_ = false;   // setCamera called since the last collected frame
+    bool cameraMoving_ = false;  // Frame being drawn follows a camera move; no static layer
+    bool fullDamage_ = true;
+    std::vector<PixelRect> pendingDamage_; // From invalidate(rect), added on the next collect
+    bool boundsCurrent_ = false; // drawStates_ match the objects for this frame
+    bool layered_ = false;       // Frame being drawn blits the static layer
+    bool cull_ = false;          // Frame being drawn culls objects by bounds
+    int damageWidth_ = 0, damageHeight_ = 0;
+    
+    // Rasterized grid lines, rebuilt when the grid, camera or surface size changes
+    mutable SurfaceHandle gridCache_;
+    mutable GridConfig gridCacheConfig_;
+    mutable int gridCacheWidth_ = 0, gridCacheHeight_ = 0;
+    mutable float gridCacheCellWidth_ = 0, gridCacheCellHeight_ = 0;
+    mutable float gridCacheOriginX_ = 0, gridCacheOriginY_ = 0;
+    mutable cairo_antialias_t gridCacheAntialias_ = CAIRO_ANTIALIAS_DEFAULT;
+    
+    SurfaceHandle staticLayer_;
+    bool staticLayerEnabled_ = true;
+    bool staticLayerValid_ = false;
+    
+    // Surface size gridToPixel lays out for; false if there is none yet
+    bool layoutSize(int& width, int& height) const;
+    
+    void track(const std::shared_ptr<Animatable>& animatable);
+    void saveCheckpoint();
+    void restoreCheckpoint(Checkpoint& checkpoint);
     
-    void drawGrid(cairo_t *cr) const;
+    bool updateLayers(const RenderContext& ctx);
+    void bakeStaticLayer(const RenderContext& ctx, const DamageRegion& region);
+    void drawGrid(cairo_t *cr, const RenderContext& ctx) const;
+    void updateGridCache(const RenderContext& ctx) const;
+    void rebuildGridCache(const RenderContext& ctx) const;
 };
 
 } // namespace banim
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "banim/damage.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace banim {
+
+// Uniform grid hash over object bounds in pixel space. Each id is stored in
+// every bucket its bounds touch, so a query costs time proportional to the
+// queried area and the objects found there, not to the number of objects.
+// Objects spanning too many buckets are kept on a separate list that every
+// query returns.
+class SpatialIndex {
+public:
+    explicit SpatialIndex(float bucketSize = 128.0f) : bucketSize_(bucketSize) {}
+
+    void clear();
+    void insert(int id, const PixelRect& bounds);
+    void remove(int id, const PixelRect& bounds);
+    void update(int id, const PixelRect& oldBounds, const PixelRect& newBounds);
+
+    // Ids whose buckets overlap rect, ascending and without duplicates. The
+    // caller tests exact bounds; the index may return near misses. Safe to
+    // call from several threads while the index is not being modified.
+    void query(const PixelRect& rect, std::vector<int>& out) const;
+
+private:
+    struct Span {
+        int x0, y0, x1, y1; // Inclusive bucket range
+        long long count() const { return static_cast<long long>(x1 - x0 + 1) * (y1 - y0 + 1); }
+    };
+
+    float bucketSize_;
+    std::unordered_map<uint64_t, std::vector<int>> buckets_;
+    std::vector<int> oversized_;
+
+    Span span(const PixelRect& rect) const;
+    static uint64_t key(int x, int y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+};
+
+} // namespace banim
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "banim/damage.h"
+#include "banim/render_context.h"
+#include "banim/surface.h"
+#include <cairo/cairo.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace banim {
+
+// Raster cache of one object's appearance. The object is rasterized once into
+// an offscreen surface and then composited with set_source_surface +
+// paint_with_alpha for as long as its visual state (the key) is unchanged, so
+// pure translations and alpha changes skip path construction and filling.
+class SpriteCache {
+public:
+    // Everything that affects the rasterized pixels except position and alpha
+    struct Key {
+        std::vector<float> values;
+        std::string text;
+        bool operator==(const Key& o) const { return values == o.values && text == o.text; }
+        bool operator!=(const Key& o) const { return !(*this == o); }
+    };
+
+    // Bring the sprite up to date for an object whose current pixel bounds
+    // are bounds and whose position is (anchorX, anchorY). render draws the
+    // object at full opacity in absolute pixel coordinates; it is called only
+    // when the key or the frame's quality settings change, or a resting
+    // object sits at a different subpixel offset than the cached image. Call
+    // once per frame, before drawing.
+    void update(const Key& key, const PixelRect& bounds, float anchorX, float anchorY,
+                const RenderContext& ctx, const std::function<void(cairo_t*)>& render);
+
+    // True if the cached image shows key; false if it is stale or the object
+    // is too large to cache, in which case the caller draws directly
+    bool ready(const Key& key) const { return surface_ && key == key_; }
+
+    // Composite the cached image for an object at (anchorX, anchorY). Only
+    // reads the cache, so several threads may composite the same sprite.
+    void composite(cairo_t* cr, float anchorX, float anchorY, float alpha) const;
+
+    void clear() { surface_.reset(); }
+
+private:
+    SurfaceHandle surface_;
+    Key key_;
+    cairo_antialias_t antialias_ = CAIRO_ANTIALIAS_DEFAULT;
+    float offsetX_ = 0, offsetY_ = 0;       // Sprite origin relative to the anchor
+    float rasterX_ = 0, rasterY_ = 0;       // Anchor when the sprite was rasterized
+    float lastX_ = 0, lastY_ = 0;           // Anchor at the previous draw
+};
+
+} // namespace banim
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "banim/grid.h"
+
+namespace banim {
+
+// Flat snapshot of object properties. Objects write their values in a fixed
+// order (Animatable::saveState) and read them back in the same order
+// (Animatable::restoreState), so the buffer holds no names or types.
+class StateBuffer {
+public:
+    void clear() { values_.clear(); strings_.clear(); rewind(); }
+    void rewind() { valuePos_ = 0; stringPos_ = 0; }
+
+    void write(float v) { values_.push_back(v); }
+    void write(bool v) { values_.push_back(v ? 1.0f : 0.0f); }
+    void write(const GridCoord& c) { values_.push_back(c.x); values_.push_back(c.y); }
+    void write(const std::vector<GridCoord>& points) {
+        write(static_cast<float>(points.size()));
+        for (const auto& p : points) write(p);
+    }
+    void write(const std::string& s) { strings_.push_back(s); }
+
+    float readFloat() { return values_[valuePos_++]; }
+    bool readBool() { return readFloat() != 0.0f; }
+    GridCoord readCoord() {
+        float x = readFloat();
+        return {x, readFloat()};
+    }
+    std::vector<GridCoord> readCoords() {
+        std::vector<GridCoord> points(static_cast<size_t>(readFloat()));
+        for (auto& p : points) p = readCoord();
+        return points;
+    }
+    std::string readString() { return strings_[stringPos_++]; }
+
+private:
+    std::vector<float> values_;
+    std::vector<std::string> strings_;
+    size_t valuePos_ = 0, stringPos_ = 0;
+};
+
+} // namespace banim
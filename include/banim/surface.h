@@ -0,0 +1,74 @@
+#pragma once
+
+#include "banim/damage.h"
+#include <cairo/cairo.h>
+#include <memory>
+
+namespace banim {
+
+class Scene;
+class ThreadPool;
+
+// Owning handle for an offscreen cairo_surface_t
+struct SurfaceDeleter {
+  void operator()(cairo_surface_t *s) const { cairo_surface_destroy(s); }
+};
+using SurfaceHandle = std::unique_ptr<cairo_surface_t, SurfaceDeleter>;
+
+// CPU-side Cairo image surface the scene is rasterized into
+class CairoSurface {
+public:
+  CairoSurface(int w, int h);
+  ~CairoSurface();
+  void recreate(int w, int h);
+
+  // Draw into caller-owned pixels (e.g. a mapped GL buffer) instead of an
+  // allocated image. data holds h rows of stride bytes, stride at least
+  // cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w), and must outlive
+  // the surface.
+  CairoSurface(unsigned char *data, int w, int h, int stride);
+  void recreate(unsigned char *data, int w, int h, int stride);
+
+  CairoSurface(const CairoSurface &) = delete;
+  CairoSurface &operator=(const CairoSurface &) = delete;
+  cairo_t *context() const { return cr_; }
+  cairo_surface_t *surface() const { return surf_; }
+  int width() const { return w_; }
+  int height() const { return h_; }
+
+  // False until a full frame has been drawn since the surface was (re)created
+  bool hasContent() const { return hasContent_; }
+  void setHasContent(bool has) { hasContent_ = has; }
+
+  // Dynamic resolution: rasterizeFrame draws the scene scaled by scale into
+  // the top-left width*scale x height*scale pixels. width() and height()
+  // stay the size the scene is laid out for. Changing it repaints everything.
+  void setScale(float scale);
+  float scale() const { return scale_; }
+
+private:
+  cairo_surface_t *surf_ = nullptr;
+  cairo_t *cr_ = nullptr;
+  int w_ = 0, h_ = 0;
+  bool hasContent_ = false;
+  float scale_ = 1.0f;
+
+  void release();
+  void attach(cairo_surface_t *surf, int w, int h);
+};
+
+// Paint the background and draw the scene into target (Cairo only, no GL).
+// Only the regions the scene reports as damaged are repainted; the rest of
+// the surface keeps the previous frame. If damage is given it receives the
+// repainted region in surface pixels (empty when nothing changed).
+void rasterizeFrame(Scene &scene, CairoSurface &target, DamageRegion *damage = nullptr);
+
+// Same result as rasterizeFrame, with the damaged area split into tiles of
+// tileSize pixels that are drawn concurrently on pool. Each tile gets its own
+// Cairo context over its rectangle of target's pixels and draws only the
+// objects overlapping it. Worth it for large targets (4K and up). Targets
+// with a scale other than 1 are drawn by rasterizeFrame.
+void rasterizeFrameTiled(Scene &scene, CairoSurface &target, ThreadPool &pool,
+                         DamageRegion *damage = nullptr, int tileSize = 256);
+
+} // namespace banim
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "banim/display_list.h"
+#include <cairo/cairo.h>
+#include <string>
+#include <vector>
+
+namespace banim {
+
+// Shared scaled fonts for the toy faces used by the built-in objects, keyed
+// by family, weight and size. Returns a new reference the caller must
+// release with cairo_scaled_font_destroy. Thread-safe.
+cairo_scaled_font_t* acquireScaledFont(const char* family, cairo_font_weight_t weight, float size);
+
+// A shaped string: glyph positions and ink extents for one text/font pair,
+// reused until the text or the size changes. Positions are relative to the
+// baseline origin.
+class GlyphRun {
+public:
+    GlyphRun() = default;
+    ~GlyphRun();
+    GlyphRun(const GlyphRun&) = delete;
+    GlyphRun& operator=(const GlyphRun&) = delete;
+
+    // Reshape if the inputs differ from the last call, otherwise a no-op
+    void update(const std::string& text, const char* family, cairo_font_weight_t weight, float size);
+
+    // True if the run is shaped for these inputs
+    bool matches(const std::string& text, const char* family, cairo_font_weight_t weight,
+                 float size) const {
+        return font_ && text == text_ && size == size_ && weight == weight_ && family_ == family;
+    }
+
+    const cairo_text_extents_t& extents() const { return extents_; }
+    bool empty() const { return glyphs_.empty(); }
+
+    // Record drawing with the current source, baseline origin at (x, y)
+    void record(DisplayList& list, double x, double y) const;
+
+private:
+    std::string text_;
+    std::string family_;
+    cairo_font_weight_t weight_ = CAIRO_FONT_WEIGHT_NORMAL;
+    float size_ = -1.0f;
+    cairo_scaled_font_t* font_ = nullptr;
+    std::vector<cairo_glyph_t> glyphs_;
+    cairo_text_extents_t extents_{};
+};
+
+} // namespace banim
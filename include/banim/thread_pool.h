@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace banim {
+
+// Fixed set of worker threads for fork/join jobs within a frame. The calling
+// thread takes part in each job, so a pool of size n uses n - 1 workers.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0); // 0 = std::thread::hardware_concurrency()
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Run job(i) for every i in [0, count) and return once all calls have
+    // finished. Indices are handed out dynamically, so uneven jobs balance.
+    // The first exception thrown by a job is rethrown here.
+    void parallelFor(int count, const std::function<void(int)>& job);
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    // Current job, guarded by mutex_
+    const std::function<void(int)>* job_ = nullptr;
+    int count_ = 0;
+    int next_ = 0;
+    int running_ = 0;
+    unsigned generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+
+    void workerLoop();
+    void runJobs(std::unique_lock<std::mutex>& lock);
+};
+
+} // namespace banim
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "banim/animatable.h"
+#include "banim/animation.h"
+#include "banim/easing.h"
+#include "banim/grid.h"
+
+namespace banim {
+
+// Values a Tween can interpolate. Overload interpolate for other value types
+// (found by argument-dependent lookup).
+inline float interpolate(float from, float to, float t) { return from + (to - from) * t; }
+inline GridCoord interpolate(const GridCoord& from, const GridCoord& to, float t) {
+    return {from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t};
+}
+
+// Property accessors for Tween. An accessor names the object type and value
+// type it works on and reads and writes the value:
+//
+//     struct P {
+//         using Target = ...;
+//         using Value = ...;
+//         Value get(const Target& target) const;
+//         void set(Target& target, const Value& value) const;
+//     };
+//
+// Accessors are stored in the tween, so they may carry parameters (see
+// Waypoint).
+namespace prop {
+
+struct GridPos {
+    using Target = Animatable;
+    using Value = GridCoord;
+    Value get(const Target& target) const { return target.getGridPos(); }
+    void set(Target& target, const Value& v) const { target.setGridPos(v.x, v.y); }
+};
+
+// Width in x, height in y
+struct Size {
+    using Target = Animatable;
+    using Value = GridCoord;
+    Value get(const Target& target) const {
+        Value v;
+        target.getAnimatableSize(v.x, v.y);
+        return v;
+    }
+    void set(Target& target, const Value& v) const { target.setAnimatableSize(v.x, v.y); }
+};
+
+struct Alpha {
+    using Target = Animatable;
+    using Value = float;
+    Value get(const Target& target) const { return target.getAlpha(); }
+    void set(Target& target, Value v) const { target.setAlpha(v); }
+};
+
+struct StrokeWidth {
+    using Target = Animatable;
+    using Value = float;
+    Value get(const Target& target) const { return target.getStrokeWidth(); }
+    void set(Target& target, Value v) const { target.setStrokeWidth(v); }
+};
+
+struct BorderRadius {
+    using Target = Rectangle;
+    using Value = float;
+    Value get(const Target& target) const { return target.getBorderRadius(); }
+    void set(Target& target, Value v) const { target.setBorderRadius(v); }
+};
+
+// Start point only; the end and waypoints stay in place
+struct LineStart {
+    using Target = Line;
+    using Value = GridCoord;
+    Value get(const Target& target) const { return target.getGridPos(); }
+    void set(Target& target, const Value& v) const { target.Animatable::setGridPos(v.x, v.y); }
+};
+
+struct LineEnd {
+    using Target = Line;
+    using Value = GridCoord;
+    Value get(const Target& target) const { return target.getEndPos(); }
+    void set(Target& target, const Value& v) const { target.setEndPos(v); }
+};
+
+struct Waypoint {
+    int index = 0;
+    using Target = Line;
+    using Value = GridCoord;
+    Value get(const Target& target) const { return target.getWaypoint(index); }
+    void set(Target& target, const Value& v) const { target.setWaypoint(index, v); }
+};
+
+} // namespace prop
+
+// True if P is a property accessor as described above
+template <typename P, typename = void>
+struct IsTweenProperty : std::false_type {};
+
+template <typename P>
+struct IsTweenProperty<P, std::void_t<
+    decltype(std::declval<const P&>().get(std::declval<const typename P::Target&>())),
+    decltype(std::declval<const P&>().set(std::declval<typename P::Target&>(),
+                                          std::declval<const typename P::Value&>())),
+    decltype(interpolate(std::declval<const typename P::Value&>(),
+                         std::declval<const typename P::Value&>(), 0.0f))>> : std::true_type {};
+
+// Tween one property of target from its value when the tween first updates
+// to `to`, over duration seconds, with Easing shaping the progress (see
+// banim/easing.h). The accessor and easing are usually empty types, so
+// update compiles to one easing call, one interpolation and one setter call.
+template <typename Property, typename Easing = ease::Linear>
+class Tween : public Animation {
+    static_assert(IsTweenProperty<Property>::value,
+                  "Property needs Target, Value, get, set and an interpolate overload for Value");
+
+  public:
+    using Target = typename Property::Target;
+    using Value = typename Property::Value;
+
+    Tween(std::shared_ptr<Target> target, const Value& to, float duration = default_duration,
+          Easing easing = Easing(), Property property = Property())
+        : target_(std::move(target)), property_(std::move(property)), easing_(std::move(easing)),
+          to_(to), duration_(duration) {}
+
+    bool update(float dt) override {
+        if (!initialized_) {
+            from_ = property_.get(*target_);
+            initialized_ = true;
+        }
+        elapsed_ += dt;
+        float t = std::min(elapsed_ / duration_, 1.0f);
+        property_.set(*target_, interpolate(from_, to_, easing_(t)));
+        return t < 1.0f;
+    }
+
+    void reset() override {
+        elapsed_ = 0.0f;
+        initialized_ = false;
+    }
+
+    Animatable* target() const override { return target_.get(); }
+
+  protected:
+    std::shared_ptr<Target> target_;
+    Property property_;
+    Easing easing_;
+    Value from_{};
+    Value to_;
+    float duration_;
+    float elapsed_ = 0.0f;
+    bool initialized_ = false;
+};
+
+// makeTween<prop::Alpha>(obj, 0.0f, 1.0f, ease::OutCubic())
+template <typename Property, typename Easing = ease::Linear>
+std::shared_ptr<Tween<Property, Easing>> makeTween(std::shared_ptr<typename Property::Target> target,
+                                                   const typename Property::Value& to,
+                                                   float duration = default_duration,
+                                                   Easing easing = Easing(),
+                                                   Property property = Property()) {
+    return std::make_shared<Tween<Property, Easing>>(std::move(target), to, duration,
+                                                     std::move(easing), std::move(property));
+}
+
+} // namespace banim
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "banim/animation.h"
+
+namespace banim {
+
+class Animatable;
+class Rectangle;
+class Scene;
+
+// Animatable properties a compiled tween can drive
+enum class TweenProperty : uint8_t {
+    X, Y,             // Grid position (setGridPos)
+    Width, Height,    // Animatable size (setAnimatableSize)
+    Alpha,
+    StrokeWidth,
+    BorderRadius,     // Rectangles only
+    Count
+};
+
+enum class EasingId : uint8_t {
+    Linear,
+    SmoothStep        // 3t^2 - 2t^3, as BorderTo
+};
+
+// Many simple tweens played as one animation, stored as structure-of-arrays
+// rows: target index, property, start and end time, from and to values and
+// easing. Rows are kept in start order; a cursor moves rows into an active
+// list when they start and they leave it when they end, so a step costs only
+// the tweens running in it (a long staggered reveal does not re-evaluate the
+// rows that are done or yet to come). Each update evaluates the active rows
+// into a per-target property buffer and then calls each touched target's
+// setters once.
+//
+// A tween starts from the value its property has when the track starts, or
+// from the end value of the previous tween on the same property, like the
+// equivalent sequence of MoveTo/ResizeTo/... animations. Tweens of one
+// property that overlap in time cannot be compiled: played as animations,
+// each starts from whatever value the other has reached by then.
+class TweenTrack : public Animation {
+  public:
+    // Tween property of target to `to` over [start, start + duration]
+    // seconds of track time. Returns false, adding nothing, if the tween
+    // overlaps one already added for the same target and property.
+    bool add(std::shared_ptr<Animatable> target, TweenProperty property, float to,
+             float start, float duration, EasingId easing = EasingId::Linear);
+
+    // Keep the track running until at least time, e.g. for a Wait
+    void extend(float time) { end_ = std::max(end_, time); }
+
+    size_t size() const { return target_.size(); }
+    float duration() const { return end_; }
+
+    bool update(float dt) override;
+    void reset() override;
+    void setScene(Scene* scene) override;
+
+  private:
+    static constexpr int kProperties = static_cast<int>(TweenProperty::Count);
+
+    // Targets, each once; rows refer to them by index
+    std::vector<std::shared_ptr<Animatable>> targets_;
+    std::vector<Rectangle*> rectangles_;  // Same index, for BorderRadius
+    std::unordered_map<const Animatable*, uint32_t> targetIndex_;
+    std::unordered_map<uint32_t, std::vector<std::pair<float, float>>> slotSpans_; // By slot, for add
+
+    // One entry per tween, sorted by start time once the track starts
+    std::vector<uint32_t> target_;
+    std::vector<uint8_t> property_;
+    std::vector<uint32_t> slot_;          // target * kProperties + property
+    std::vector<float> start_, finish_, invDuration_;
+    std::vector<float> from_, to_;
+    std::vector<float> smooth_;           // 1 for SmoothStep, 0 for Linear
+
+    size_t next_ = 0;                     // First row not started yet
+    std::vector<uint32_t> active_;        // Rows started and not ended, in row order
+
+    std::vector<float> properties_;       // targets_ x kProperties
+    std::vector<uint8_t> touched_;        // Per target, bit per property
+    std::vector<uint32_t> touchedTargets_; // Targets with touched_ set
+
+    float end_ = 0;
+    float elapsed_ = 0;
+    float previous_ = 0;                  // elapsed_ before this update
+    bool started_ = false;
+    bool sorted_ = true;                  // Rows are in start order
+    Scene* scene_ = nullptr;              // For its update pool
+
+    void sortRows();
+    void start();
+    void readProperties();
+    void apply();
+    void applyTargets(size_t begin, size_t end); // touchedTargets_[begin, end)
+};
+
+} // namespace banim
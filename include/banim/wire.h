@@ -2,13 +2,17 @@
 
 #include "banim/animatable.h"
 #include "banim/port_interface.h"
+#include <atomic>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace banim {
 
-class Wire : public Line {
+// Follows its providers: they notify the wire when they move, resize or
+// change ports, and it re-routes on the next syncGeometry, which the scene
+// calls before drawing. Drawing never changes the wire.
+class Wire : public Line, public IPortListener {
 public:
     // Simple API: Connect two port providers by port names
     Wire(std::shared_ptr<IPortProvider> fromProvider, const std::string& fromPortName,
@@ -18,11 +22,21 @@ public:
     Wire(std::shared_ptr<IPortProvider> fromProvider, PortDirection fromDirection, int fromPortIndex,
          std::shared_ptr<IPortProvider> toProvider, PortDirection toDirection, int toPortIndex);
     
+    ~Wire() override;
+    Wire(const Wire&) = delete;
+    Wire& operator=(const Wire&) = delete;
+    
     // Update wire routing when blocks move
     void updateRouting();
     
-    // Override draw to ensure routing is up to date
-    void draw(cairo_t* cr) override;
+    // Re-route if an endpoint provider changed since the last frame
+    void syncGeometry() override;
+    PixelRect getPixelBounds(const RenderContext& ctx) const override;
+    
+    void restoreState(StateBuffer& state) override;
+    
+    // Only flags the wire, so providers may change on any thread
+    void portsChanged(IPortProvider& provider) override;
     
     // Get the connected providers
     std::shared_ptr<IPortProvider> getFromProvider() const { return fromProvider_; }
@@ -32,6 +46,10 @@ public:
     void setAutoRoute(bool enable) { autoRoute_ = enable; }
     bool isAutoRoute() const { return autoRoute_; }
 
+protected:
+    // Port to port without the cell-centering offset
+    void recordPath(DisplayList& list, const RenderContext& ctx) const override;
+
 private:
     std::shared_ptr<IPortProvider> fromProvider_;
     std::shared_ptr<IPortProvider> toProvider_;
@@ -44,15 +62,13 @@ private:
     bool usePortNames_;
     bool autoRoute_;
     
-    // Track last known provider positions to detect movement
-    GridCoord lastFromProviderPos_;
-    GridCoord lastToProviderPos_;
+    // Set by providers, cleared by updateRouting
+    std::atomic<bool> routingDirty_{false};
     
     void calculateAutoRoute();
     std::vector<GridCoord> generatePathBetweenPorts(const Port* fromPort, const Port* toPort);
     Port* getFromPort();
     Port* getToPort();
-    bool needsRoutingUpdate();
 };
 
 } // namespace banim
@@ -1,12 +1,91 @@
 #include "banim/animatable.h"
 #include "banim/scene.h"
 #include "banim/animations.h"
-#include "banim/init.h"
+#include "banim/surface.h"
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
 namespace banim {
 
+// ────────────── BOUNDS ──────────────
+
+namespace {
+
+// Antialiasing spills up to a pixel past the geometric edge
+constexpr float kAntialiasPad = 1.0f;
+
+} // namespace
+
+PixelRect Animatable::getPixelBounds(const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
+    PixelRect box = PixelRect::rotated(gridPos_.x * cellWidth, gridPos_.y * cellHeight,
+                                       gridSize_.x * cellWidth, gridSize_.y * cellHeight,
+                                       rotation_);
+    return box.inflated(strokeWidth_ * 0.5f + kAntialiasPad);
+}
+
+// ────────────── CHECKPOINT STATE ──────────────
+
+void Animatable::saveState(StateBuffer& state) const {
+    state.write(gridPos_);
+    state.write(gridSize_);
+    state.write(r_); state.write(g_); state.write(b_); state.write(a_);
+    state.write(rotation_);
+    state.write(strokeWidth_);
+    state.write(filled_);
+}
+
+void Animatable::restoreState(StateBuffer& state) {
+    gridPos_ = state.readCoord();
+    gridSize_ = state.readCoord();
+    r_ = state.readFloat(); g_ = state.readFloat(); b_ = state.readFloat(); a_ = state.readFloat();
+    rotation_ = state.readFloat();
+    strokeWidth_ = state.readFloat();
+    filled_ = state.readBool();
+    markDirty();
+}
+
+// ────────────── DISPLAY LIST ──────────────
+
+bool Animatable::displayListCurrent(const RenderContext& ctx) const {
+    return listVersion_ == version_ && listCellWidth_ == ctx.cellWidth &&
+           listCellHeight_ == ctx.cellHeight && listZoom_ == ctx.zoom &&
+           listDetail_ == ctx.quality.detailMinPixels;
+}
+
+void Animatable::updateDisplayList(const RenderContext& ctx) {
+    if (displayListCurrent(ctx)) return;
+    displayList_.clear();
+    record(displayList_, ctx, a_);
+    listVersion_ = version_;
+    listCellWidth_ = ctx.cellWidth;
+    listCellHeight_ = ctx.cellHeight;
+    listZoom_ = ctx.zoom;
+    listDetail_ = ctx.quality.detailMinPixels;
+}
+
+void Animatable::draw(cairo_t* cr, const RenderContext& ctx) {
+    render(cr, ctx, a_);
+}
+
+void Animatable::render(cairo_t* cr, const RenderContext& ctx, float alpha) const {
+    if (alpha == a_ && displayListCurrent(ctx)) {
+        displayList_.replay(cr);
+        return;
+    }
+    // Not prepared for this frame (or drawn at another alpha): record a
+    // throwaway list instead of touching the shared one
+    DisplayList list;
+    record(list, ctx, alpha);
+    list.replay(cr);
+}
+
+bool Animatable::pathStyle(const RenderContext& ctx, PathStyle& style) const {
+    return displayListCurrent(ctx) && displayList_.singlePaint(style);
+}
+
 // ────────────── RECTANGLE ──────────────
 
 Rectangle::Rectangle(const GridCoord& gridPos, float gridWidth, float gridHeight,
@@ -20,53 +99,90 @@ Rectangle::Rectangle(const GridCoord& gridPos, float gridWidth, float gridHeight
 
 Rectangle& Rectangle::setBorderRadius(float radius) {
     borderRadius_ = radius;
+    markDirty();
     return *this;
 }
 
-void Rectangle::draw(cairo_t* cr) {
-    if (!g_ctx) return;
-    
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
-    
-    // Convert grid coordinates to pixel coordinates
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
+SpriteCache::Key Rectangle::spriteKey(float cellWidth, float cellHeight) const {
+    return {{gridSize_.x * cellWidth, gridSize_.y * cellHeight,
+             r_, g_, b_, rotation_, strokeWidth_, filled_ ? 1.0f : 0.0f, borderRadius_}};
+}
+
+void Rectangle::saveState(StateBuffer& state) const {
+    Animatable::saveState(state);
+    state.write(borderRadius_);
+}
+
+void Rectangle::restoreState(StateBuffer& state) {
+    Animatable::restoreState(state);
+    borderRadius_ = state.readFloat();
+}
+
+bool Rectangle::pathStyle(const RenderContext& ctx, PathStyle& style) const {
+    if (spriteCaching_ && (rotation_ != 0.0f || borderRadius_ > 0.0f)) return false;
+    return Animatable::pathStyle(ctx, style);
+}
+
+void Rectangle::prepareDraw(const RenderContext& ctx) {
+    Animatable::prepareDraw(ctx);
+    // A plain box is cheaper to fill in a batch than to composite
+    PathStyle style;
+    if (!spriteCaching_ || pathStyle(ctx, style)) return;
+    sprite_.update(spriteKey(ctx.cellWidth, ctx.cellHeight),
+                   getPixelBounds(ctx),
+                   gridPos_.x * ctx.cellWidth, gridPos_.y * ctx.cellHeight, ctx,
+                   [&](cairo_t* sprite) { render(sprite, ctx, 1.0f); });
+}
+
+void Rectangle::draw(cairo_t* cr, const RenderContext& ctx) {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
+    if (spriteCaching_ && sprite_.ready(spriteKey(cellWidth, cellHeight))) {
+        sprite_.composite(cr, gridPos_.x * cellWidth, gridPos_.y * cellHeight, a_);
+        return;
+    }
+    Animatable::draw(cr, ctx);
+}
+
+void Rectangle::record(DisplayList& list, const RenderContext& ctx, float alpha) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     float pixelX = gridPos_.x * cellWidth;
     float pixelY = gridPos_.y * cellHeight;
     float pixelW = gridSize_.x * cellWidth;
     float pixelH = gridSize_.y * cellHeight;
     
-    cairo_save(cr);
-    cairo_translate(cr, pixelX + pixelW / 2, pixelY + pixelH / 2);
-    cairo_rotate(cr, rotation_);
-    cairo_translate(cr, -pixelW / 2, -pixelH / 2);
+    list.save();
+    if (rotation_ != 0.0f) {
+        list.translate(pixelX + pixelW / 2, pixelY + pixelH / 2);
+        list.rotate(rotation_);
+        list.translate(-pixelW / 2, -pixelH / 2);
+    } else {
+        list.translate(pixelX, pixelY);
+    }
 
     if (borderRadius_ > 0.0f) {
         float r = std::min(borderRadius_, std::min(pixelW / 2, pixelH / 2));
-        cairo_new_sub_path(cr);
-        cairo_arc(cr, pixelW - r, r, r, -M_PI_2, 0);
-        cairo_arc(cr, pixelW - r, pixelH - r, r, 0, M_PI_2);
-        cairo_arc(cr, r, pixelH - r, r, M_PI_2, M_PI);
-        cairo_arc(cr, r, r, r, M_PI, 3 * M_PI_2);
-        cairo_close_path(cr);
+        list.newSubPath();
+        list.arc(pixelW - r, r, r, -M_PI_2, 0);
+        list.arc(pixelW - r, pixelH - r, r, 0, M_PI_2);
+        list.arc(r, pixelH - r, r, M_PI_2, M_PI);
+        list.arc(r, r, r, M_PI, 3 * M_PI_2);
+        list.closePath();
     } else {
-        cairo_rectangle(cr, 0, 0, pixelW, pixelH);
+        list.rectangle(0, 0, pixelW, pixelH);
     }
 
-    cairo_set_line_width(cr, strokeWidth_);
-    cairo_set_source_rgba(cr, r_, g_, b_, a_);
+    list.setLineWidth(strokeWidth_);
+    list.setSourceRgba(r_, g_, b_, alpha);
     if (filled_)
-        cairo_fill(cr);
+        list.fill();
     else
-        cairo_stroke(cr);
+        list.stroke();
 
-    cairo_restore(cr);
+    list.restore();
 }
 
 // ────────────── CIRCLE ──────────────
@@ -80,43 +196,81 @@ Circle::Circle(const GridCoord& gridPos, float gridRx, float gridRy,
     rotation_ = rotation;
 }
 
-void Circle::draw(cairo_t *cr) {
-    if (!g_ctx) return;
+PixelRect Circle::getPixelBounds(const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
+    float cx = (gridPos_.x + 0.5f) * cellWidth;
+    float cy = (gridPos_.y + 0.5f) * cellHeight;
+    float rx = std::fabs(gridSize_.x * cellWidth * 0.5f);
+    float ry = std::fabs(gridSize_.y * cellHeight * 0.5f);
     
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
+    // Axis-aligned extent of the rotated ellipse
+    float c = std::cos(rotation_), s = std::sin(rotation_);
+    float ex = std::sqrt(rx * rx * c * c + ry * ry * s * s);
+    float ey = std::sqrt(rx * rx * s * s + ry * ry * c * c);
     
-    // Convert grid coordinates to pixel coordinates
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
+    PixelRect box{cx - ex, cy - ey, cx + ex, cy + ey};
+    return box.inflated(strokeWidth_ * 0.5f + kAntialiasPad);
+}
+
+SpriteCache::Key Circle::spriteKey(float cellWidth, float cellHeight) const {
+    return {{gridSize_.x * cellWidth, gridSize_.y * cellHeight,
+             r_, g_, b_, rotation_, strokeWidth_, filled_ ? 1.0f : 0.0f}};
+}
+
+bool Circle::pathStyle(const RenderContext& ctx, PathStyle& style) const {
+    return !spriteCaching_ && Animatable::pathStyle(ctx, style);
+}
+
+void Circle::prepareDraw(const RenderContext& ctx) {
+    Animatable::prepareDraw(ctx);
+    if (!spriteCaching_) return;
+    sprite_.update(spriteKey(ctx.cellWidth, ctx.cellHeight),
+                   getPixelBounds(ctx),
+                   gridPos_.x * ctx.cellWidth, gridPos_.y * ctx.cellHeight, ctx,
+                   [&](cairo_t* sprite) { render(sprite, ctx, 1.0f); });
+}
+
+void Circle::draw(cairo_t* cr, const RenderContext& ctx) {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
+    if (spriteCaching_ && sprite_.ready(spriteKey(cellWidth, cellHeight))) {
+        sprite_.composite(cr, gridPos_.x * cellWidth, gridPos_.y * cellHeight, a_);
+        return;
+    }
+    Animatable::draw(cr, ctx);
+}
+
+void Circle::record(DisplayList& list, const RenderContext& ctx, float alpha) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     float pixelX = (gridPos_.x + 0.5f) * cellWidth;  // Center of grid cell
     float pixelY = (gridPos_.y + 0.5f) * cellHeight;
     float pixelRx = gridSize_.x * cellWidth * 0.5f;
     float pixelRy = gridSize_.y * cellHeight * 0.5f;
     
-    cairo_save(cr);
-    cairo_translate(cr, pixelX, pixelY);
-    cairo_rotate(cr, rotation_);
-
-    cairo_save(cr);
-    cairo_scale(cr, pixelRx, pixelRy);
-    cairo_arc(cr, 0, 0, 1.0, 0, 2 * M_PI);
-    cairo_restore(cr);
-
-    cairo_set_source_rgba(cr, r_, g_, b_, a_);
+    list.save();
+    list.translate(pixelX, pixelY);
+    list.rotate(rotation_);
+
+    // A new sub-path, so a batch does not join this circle to the last one
+    list.save();
+    list.scale(pixelRx, pixelRy);
+    list.newSubPath();
+    list.arc(0, 0, 1.0, 0, 2 * M_PI);
+    list.restore();
+
+    list.setSourceRgba(r_, g_, b_, alpha);
     if (filled_) {
-        cairo_fill(cr);
+        list.fill();
     } else {
-        cairo_set_line_width(cr, strokeWidth_);
-        cairo_stroke(cr);
+        list.setLineWidth(strokeWidth_);
+        list.stroke();
     }
 
-    cairo_restore(cr);
+    list.restore();
 }
 
 // ────────────── LINE ──────────────
@@ -132,11 +286,13 @@ Line::Line(const GridCoord& startPos, const GridCoord& endPos,
 
 void Line::addWaypoint(const GridCoord& waypoint) {
     waypoints_.push_back(waypoint);
+    markDirty();
 }
 
 void Line::setWaypoint(int index, const GridCoord& waypoint) {
     if (index >= 0 && index < static_cast<int>(waypoints_.size())) {
         waypoints_[index] = waypoint;
+        markDirty();
     }
 }
 
@@ -150,11 +306,13 @@ GridCoord Line::getWaypoint(int index) const {
 void Line::removeWaypoint(int index) {
     if (index >= 0 && index < static_cast<int>(waypoints_.size())) {
         waypoints_.erase(waypoints_.begin() + index);
+        markDirty();
     }
 }
 
 void Line::clearWaypoints() {
     waypoints_.clear();
+    markDirty();
 }
 
 void Line::moveBy(float deltaX, float deltaY) {
@@ -167,6 +325,7 @@ void Line::moveBy(float deltaX, float deltaY) {
         waypoint.x += deltaX;
         waypoint.y += deltaY;
     }
+    markDirty();
 }
 
 void Line::moveTo(const GridCoord& newStartPos) {
@@ -175,45 +334,69 @@ void Line::moveTo(const GridCoord& newStartPos) {
     moveBy(deltaX, deltaY);
 }
 
-void Line::draw(cairo_t *cr) {
-    if (!g_ctx) return;
-    
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
-    
-    // Convert grid coordinates to pixel coordinates
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
+PixelRect Line::polylineBounds(float cellWidth, float cellHeight, float offset) const {
+    float minX = gridPos_.x, maxX = gridPos_.x;
+    float minY = gridPos_.y, maxY = gridPos_.y;
+    auto extend = [&](const GridCoord& p) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+    };
+    for (const auto& waypoint : waypoints_) extend(waypoint);
+    extend(endPos_);
     
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
+    PixelRect box{(minX + offset) * cellWidth, (minY + offset) * cellHeight,
+                  (maxX + offset) * cellWidth, (maxY + offset) * cellHeight};
+    // Miter joins can reach miter-limit (10) * half the stroke width past a corner
+    return box.inflated(strokeWidth_ * 5.0f + kAntialiasPad);
+}
+
+PixelRect Line::getPixelBounds(const RenderContext& ctx) const {
+    return polylineBounds(ctx.cellWidth, ctx.cellHeight, 0.5f);
+}
+
+void Line::saveState(StateBuffer& state) const {
+    Animatable::saveState(state);
+    state.write(endPos_);
+    state.write(waypoints_);
+}
+
+void Line::restoreState(StateBuffer& state) {
+    Animatable::restoreState(state);
+    endPos_ = state.readCoord();
+    waypoints_ = state.readCoords();
+}
+
+void Line::record(DisplayList& list, const RenderContext& ctx, float alpha) const {
+    list.save();
     
-    cairo_save(cr);
+    list.setSourceRgba(r_, g_, b_, alpha);
+    list.setLineWidth(strokeWidth_);
+    recordPath(list, ctx);
+    list.stroke();
     
-    cairo_set_source_rgba(cr, r_, g_, b_, a_);
-    cairo_set_line_width(cr, strokeWidth_);
+    list.restore();
+}
+
+void Line::recordPath(DisplayList& list, const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     // Start from the start position
     float currentX = (gridPos_.x + 0.5f) * cellWidth;
     float currentY = (gridPos_.y + 0.5f) * cellHeight;
-    cairo_move_to(cr, currentX, currentY);
+    list.moveTo(currentX, currentY);
     
     // Draw through all waypoints
     for (const auto& waypoint : waypoints_) {
         float waypointX = (waypoint.x + 0.5f) * cellWidth;
         float waypointY = (waypoint.y + 0.5f) * cellHeight;
-        cairo_line_to(cr, waypointX, waypointY);
+        list.lineTo(waypointX, waypointY);
     }
     
     // End at the end position
     float endPixelX = (endPos_.x + 0.5f) * cellWidth;
     float endPixelY = (endPos_.y + 0.5f) * cellHeight;
-    cairo_line_to(cr, endPixelX, endPixelY);
-    
-    cairo_stroke(cr);
-    
-    cairo_restore(cr);
+    list.lineTo(endPixelX, endPixelY);
 }
 
 // ────────────── TEXT ──────────────
@@ -228,38 +411,83 @@ Text::Text(const GridCoord& gridPos,
     gridSize_ = {1.0f, 1.0f}; // Text doesn't really have a grid size
 }
 
-void Text::setText(const std::string& content) { content_ = content; }
-void Text::setFontSize(float size) { fontSize_ = size; }
+void Text::setText(const std::string& content) { content_ = content; markDirty(); }
+void Text::setFontSize(float size) { fontSize_ = size; markDirty(); }
 
-void Text::draw(cairo_t* cr) {
-    if (!g_ctx) return;
-    
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
+void Text::saveState(StateBuffer& state) const {
+    Animatable::saveState(state);
+    state.write(content_);
+    state.write(fontSize_);
+}
+
+void Text::restoreState(StateBuffer& state) {
+    Animatable::restoreState(state);
+    content_ = state.readString();
+    fontSize_ = state.readFloat();
+}
+
+PixelRect Text::getPixelBounds(const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
+    float pixelX = (gridPos_.x + 0.5f) * cellWidth;
+    float pixelY = (gridPos_.y + 0.5f) * cellHeight;
+    GlyphRun scratch;
+    const cairo_text_extents_t& extents = glyphRun(ctx, scratch).extents();
+    PixelRect box{pixelX + static_cast<float>(extents.x_bearing),
+                  pixelY + static_cast<float>(extents.y_bearing),
+                  pixelX + static_cast<float>(extents.x_bearing + extents.width),
+                  pixelY + static_cast<float>(extents.y_bearing + extents.height)};
+    return box.inflated(kAntialiasPad + 1.0f);
+}
+
+const GlyphRun& Text::glyphRun(const RenderContext& ctx, GlyphRun& scratch) const {
+    float size = fontSize_ * ctx.zoom;
+    if (run_.matches(content_, "Sans", CAIRO_FONT_WEIGHT_NORMAL, size)) return run_;
+    scratch.update(content_, "Sans", CAIRO_FONT_WEIGHT_NORMAL, size);
+    return scratch;
+}
+
+SpriteCache::Key Text::spriteKey(const RenderContext& ctx) const {
+    return {{fontSize_ * ctx.zoom, r_, g_, b_}, content_};
+}
+
+void Text::prepareDraw(const RenderContext& ctx) {
+    run_.update(content_, "Sans", CAIRO_FONT_WEIGHT_NORMAL, fontSize_ * ctx.zoom);
+    Animatable::prepareDraw(ctx);
+    if (!spriteCaching_) return;
+    sprite_.update(spriteKey(ctx), getPixelBounds(ctx),
+                   (gridPos_.x + 0.5f) * ctx.cellWidth, (gridPos_.y + 0.5f) * ctx.cellHeight, ctx,
+                   [&](cairo_t* sprite) { render(sprite, ctx, 1.0f); });
+}
+
+void Text::draw(cairo_t* cr, const RenderContext& ctx) {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
-    // Convert grid coordinates to pixel coordinates
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
+    float pixelX = (gridPos_.x + 0.5f) * cellWidth;  // Center of grid cell
+    float pixelY = (gridPos_.y + 0.5f) * cellHeight;
     
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
+    if (spriteCaching_ && sprite_.ready(spriteKey(ctx))) {
+        sprite_.composite(cr, pixelX, pixelY, a_);
+        return;
+    }
+    Animatable::draw(cr, ctx);
+}
+
+void Text::record(DisplayList& list, const RenderContext& ctx, float alpha) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     float pixelX = (gridPos_.x + 0.5f) * cellWidth;  // Center of grid cell
     float pixelY = (gridPos_.y + 0.5f) * cellHeight;
     
-    cairo_save(cr);
-
-    cairo_set_source_rgba(cr, r_, g_, b_, a_);
-    cairo_select_font_face(cr, "Sans",
-                           CAIRO_FONT_SLANT_NORMAL,
-                           CAIRO_FONT_WEIGHT_NORMAL);
-    cairo_set_font_size(cr, fontSize_);
+    list.save();
 
-    cairo_move_to(cr, pixelX, pixelY);
-    cairo_show_text(cr, content_.c_str());
+    list.setSourceRgba(r_, g_, b_, alpha);
+    GlyphRun scratch;
+    glyphRun(ctx, scratch).record(list, pixelX, pixelY);
 
-    cairo_restore(cr);
+    list.restore();
 }
 
 } // namespace banim
@@ -1,13 +1,23 @@
 #include "banim/animations.h"
 #include <banim/animatable.h>
 #include <banim/scene.h>
+#include <banim/thread_pool.h>
+#include <banim/tween_track.h>
 #include <cmath>
 #include <algorithm>
+#include <functional>
 
 #include <iostream>
 
 namespace banim {
 
+namespace {
+
+// Groups smaller than this update on the calling thread
+constexpr size_t kParallelMinAnimations = 256;
+
+} // namespace
+
 PopIn::PopIn(std::shared_ptr<Animatable> animatable, float duration)
     : animatable_(animatable), duration_(duration) {
     animatable_->getAnimatableSize(targetW_, targetH_);
@@ -34,81 +44,42 @@ bool PopIn::update(float dt) {
     return t < 1.0f;
 }
 
-MoveTo::MoveTo(std::shared_ptr<Animatable> target, const GridCoord& toGrid, float duration)
-    : target_(target), toGrid_(toGrid), duration_(duration) {}
+void PopIn::reset() {
+    elapsed_ = 0.0f;
+    started_ = false;
+}
 
-bool MoveTo::update(float dt) {
-    if (!initialized_) {
-        fromGrid_ = target_->getGridPos();
-        initialized_ = true;
-    }
-    elapsed_ += dt;
-    float t = elapsed_ / duration_;
-    if (t > 1.0f)
-        t = 1.0f;
+Animatable* PopIn::target() const { return animatable_.get(); }
 
-    float newX = fromGrid_.x + (toGrid_.x - fromGrid_.x) * t;
-    float newY = fromGrid_.y + (toGrid_.y - fromGrid_.y) * t;
-    target_->setGridPos(newX, newY);
+MoveTo::MoveTo(std::shared_ptr<Animatable> target, const GridCoord& toGrid, float duration)
+    : Tween(std::move(target), toGrid, duration) {}
 
-    return t < 1.0f;
+bool MoveTo::compile(TweenTrack& track, float start) const {
+    return track.add(target_, TweenProperty::X, to_.x, start, duration_) &&
+           track.add(target_, TweenProperty::Y, to_.y, start, duration_);
 }
 
 ResizeTo::ResizeTo(std::shared_ptr<Animatable> animatable, float gridW, float gridH, float duration)
-    : animatable_(animatable), targetW_(gridW), targetH_(gridH), duration_(duration) {}
-
-bool ResizeTo::update(float dt) {
-    if (!initialized_) {
-        animatable_->getAnimatableSize(startW_, startH_);
-        initialized_ = true;
-    }
-
-    elapsed_ += dt;
-    float t = elapsed_ / duration_;
-    if (t > 1.0f) t = 1.0f;
-
-    float newW = startW_ + (targetW_ - startW_) * t;
-    float newH = startH_ + (targetH_ - startH_) * t;
-    
-    animatable_->setAnimatableSize(newW, newH);
+    : Tween(std::move(animatable), GridCoord(gridW, gridH), duration) {}
 
-    return t < 1.0f;
+bool ResizeTo::compile(TweenTrack& track, float start) const {
+    return track.add(target_, TweenProperty::Width, to_.x, start, duration_) &&
+           track.add(target_, TweenProperty::Height, to_.y, start, duration_);
 }
 
 BorderTo::BorderTo(std::shared_ptr<Rectangle> rect, float targetRadius, float duration)
-    : rect_(rect), targetRadius_(targetRadius), duration_(duration) {}
+    : Tween(std::move(rect), targetRadius, duration) {}
 
-bool BorderTo::update(float dt) {
-    if (!initialized_) {
-        startRadius_ = rect_->getBorderRadius();
-        initialized_ = true;
-    }
-
-    elapsed_ += dt;
-    float t = elapsed_ / duration_;
-    if (t > 1.0f) t = 1.0f;
-
-    // Ease-in-out interpolation
-    t = t * t * (3 - 2 * t);
-
-    float newRadius = startRadius_ + (targetRadius_ - startRadius_) * t;
-    rect_->setBorderRadius(newRadius);
-
-    return t < 1.0f;
+bool BorderTo::compile(TweenTrack& track, float start) const {
+    return track.add(target_, TweenProperty::BorderRadius, to_, start, duration_,
+                     EasingId::SmoothStep);
 }
 
-
 StrokeTo::StrokeTo(std::shared_ptr<Animatable> animatable, float targetStroke, float duration)
-    : animatable_(animatable), targetStroke_(targetStroke), duration_(duration) {
-    startStroke_ = animatable_->getStrokeWidth();
-}
+    : Tween(std::move(animatable), targetStroke, duration) {}
 
-bool StrokeTo::update(float dt) {
-    elapsed_ += dt;
-    float t = std::min(elapsed_ / duration_, 1.0f);
-    float newStroke = startStroke_ + t * (targetStroke_ - startStroke_);
-    animatable_->setStrokeWidth(newStroke);
-    return t < 1.0f;
+bool StrokeTo::compile(TweenTrack& track, float start) const {
+    return track.add(target_, TweenProperty::StrokeWidth, to_, start, duration_);
 }
 
 Wait::Wait(float duration) : duration_(duration) {}
@@ -118,75 +89,29 @@ bool Wait::update(float dt) {
     return elapsed_ < duration_;
 }
 
+void Wait::reset() { elapsed_ = 0.0f; }
+
+bool Wait::compile(TweenTrack& track, float start) const {
+    track.extend(start + duration_);
+    return true;
+}
+
 MoveWaypoint::MoveWaypoint(std::shared_ptr<Line> line, int waypointIndex, const GridCoord& targetPos, float duration)
-    : line_(line), waypointIndex_(waypointIndex), targetPos_(targetPos), duration_(duration) {}
+    : Tween(std::move(line), targetPos, duration, ease::Linear(), prop::Waypoint{waypointIndex}) {}
 
 bool MoveWaypoint::update(float dt) {
-    if (!initialized_) {
-        if (waypointIndex_ >= 0 && waypointIndex_ < line_->getWaypointCount()) {
-            startPos_ = line_->getWaypoint(waypointIndex_);
-            initialized_ = true;
-        } else {
-            return false; // Invalid waypoint index
-        }
+    int index = property_.index;
+    if (!initialized_ && (index < 0 || index >= target_->getWaypointCount())) {
+        return false; // Invalid waypoint index
     }
-    
-    elapsed_ += dt;
-    float t = elapsed_ / duration_;
-    if (t > 1.0f) t = 1.0f;
-    
-    float newX = startPos_.x + (targetPos_.x - startPos_.x) * t;
-    float newY = startPos_.y + (targetPos_.y - startPos_.y) * t;
-    line_->setWaypoint(waypointIndex_, {newX, newY});
-    
-    return t < 1.0f;
+    return Tween::update(dt);
 }
 
 MoveLineEnd::MoveLineEnd(std::shared_ptr<Line> line, const GridCoord& targetEndPos, float duration)
-    : line_(line), targetEndPos_(targetEndPos), duration_(duration) {}
-
-bool MoveLineEnd::update(float dt) {
-    if (!initialized_) {
-        startEndPos_ = line_->getEndPos();
-        initialized_ = true;
-    }
-    
-    elapsed_ += dt;
-    float t = elapsed_ / duration_;
-    if (t > 1.0f) t = 1.0f;
-    
-    float newX = startEndPos_.x + (targetEndPos_.x - startEndPos_.x) * t;
-    float newY = startEndPos_.y + (targetEndPos_.y - startEndPos_.y) * t;
-    line_->setEndPos({newX, newY});
-    
-    return t < 1.0f;
-}
+    : Tween(std::move(line), targetEndPos, duration) {}
 
 MoveLineStart::MoveLineStart(std::shared_ptr<Line> line, const GridCoord& targetStartPos, float duration)
-    : line_(line), targetStartPos_(targetStartPos), duration_(duration) {}
-
-bool MoveLineStart::update(float dt) {
-    if (!initialized_) {
-        startStartPos_ = line_->getGridPos();
-        initialized_ = true;
-    }
-    
-    elapsed_ += dt;
-    float t = elapsed_ / duration_;
-    if (t > 1.0f) t = 1.0f;
-    
-    float newX = startStartPos_.x + (targetStartPos_.x - startStartPos_.x) * t;
-    float newY = startStartPos_.y + (targetStartPos_.y - startStartPos_.y) * t;
-    
-    // Move only the start position, keeping end and waypoints in place
-    float deltaX = newX - line_->getGridPos().x;
-    float deltaY = newY - line_->getGridPos().y;
-    
-    // Update the base grid position directly (just the start point)
-    line_->Animatable::setGridPos(newX, newY);
-    
-    return t < 1.0f;
-}
+    : Tween(std::move(line), targetStartPos, duration) {}
 
 RemoveWaypoint::RemoveWaypoint(std::shared_ptr<Line> line, int waypointIndex, float duration)
     : line_(line), waypointIndex_(waypointIndex), duration_(duration) {}
@@ -248,6 +173,13 @@ bool RemoveWaypoint::update(float dt) {
     return t < 1.0f;
 }
 
+void RemoveWaypoint::reset() {
+    elapsed_ = 0.0f;
+    initialized_ = false;
+}
+
+Animatable* RemoveWaypoint::target() const { return line_.get(); }
+
 ClearWaypoints::ClearWaypoints(std::shared_ptr<Line> line, float duration)
     : line_(line), duration_(duration) {}
 
@@ -293,6 +225,14 @@ bool ClearWaypoints::update(float dt) {
     return true;
 }
 
+void ClearWaypoints::reset() {
+    elapsed_ = 0.0f;
+    initialized_ = false;
+    originalWaypoints_.clear();
+}
+
+Animatable* ClearWaypoints::target() const { return line_.get(); }
+
 AddWaypoint::AddWaypoint(std::shared_ptr<Line> line, const GridCoord& newWaypoint, float duration)
     : line_(line), targetWaypoint_(newWaypoint), duration_(duration) {}
 
@@ -324,6 +264,46 @@ bool AddWaypoint::update(float dt) {
     return t < 1.0f;
 }
 
+void AddWaypoint::reset() {
+    elapsed_ = 0.0f;
+    initialized_ = false;
+    waypointIndex_ = -1;
+}
+
+Animatable* AddWaypoint::target() const { return line_.get(); }
+
+// Zoom is interpolated geometrically, which needs both ends positive
+static constexpr float kMinCameraZoom = 1e-3f;
+
+CameraTo::CameraTo(Scene& scene, const GridCoord& center, float zoom, float duration)
+    : scene_(&scene), toCenter_(center), toZoom_(std::max(zoom, kMinCameraZoom)),
+      duration_(duration) {}
+
+bool CameraTo::update(float dt) {
+    if (!initialized_) {
+        Camera camera = scene_->getCamera();
+        fromCenter_ = camera.center;
+        fromZoom_ = std::max(camera.zoom, kMinCameraZoom);
+        initialized_ = true;
+    }
+    elapsed_ += dt;
+    float t = elapsed_ / duration_;
+    if (t > 1.0f)
+        t = 1.0f;
+
+    GridCoord center(fromCenter_.x + (toCenter_.x - fromCenter_.x) * t,
+                     fromCenter_.y + (toCenter_.y - fromCenter_.y) * t);
+    float zoom = fromZoom_ * std::pow(toZoom_ / fromZoom_, t);
+    scene_->setCamera(Camera(center, zoom));
+
+    return t < 1.0f;
+}
+
+void CameraTo::reset() {
+    elapsed_ = 0.0f;
+    initialized_ = false;
+}
+
 // AddToScene implementation
 AddToScene::AddToScene(std::shared_ptr<Animatable> animatable, std::shared_ptr<Animation> spawnAnimation)
     : animatable_(animatable), spawnAnimation_(spawnAnimation) {
@@ -356,48 +336,234 @@ bool AddToScene::update(float dt) {
     return false;
 }
 
+void AddToScene::reset() {
+    added_ = false;
+    if (spawnAnimation_) spawnAnimation_->reset();
+}
+
 // AnimationGroup implementation
 void AnimationGroup::add(std::shared_ptr<Animation> animation) {
     if (animation) {
+        running_.push_back(static_cast<uint32_t>(animations_.size()));
+        targets_.push_back(animation->target());
         animations_.push_back(animation);
     }
 }
 
 void AnimationGroup::addAll(const std::vector<std::shared_ptr<Animation>>& animations) {
     for (auto& anim : animations) {
-        if (anim) {
-            animations_.push_back(anim);
-        }
+        add(anim);
+    }
+}
+
+bool AnimationGroup::compile(TweenTrack& track, float start) const {
+    for (const auto& anim : animations_) {
+        if (!anim->compile(track, start)) return false;
+    }
+    return true;
+}
+
+void AnimationGroup::reset() {
+    running_.clear();
+    for (size_t i = 0; i < animations_.size(); ++i) {
+        animations_[i]->reset();
+        running_.push_back(static_cast<uint32_t>(i));
     }
 }
 
 // Method to set scene for all AddToScene animations in the group
 void AnimationGroup::setScene(Scene* scene) {
+    scene_ = scene;
     for (auto& anim : animations_) {
-        auto addToScene = std::dynamic_pointer_cast<AddToScene>(anim);
-        if (addToScene) {
-            addToScene->setScene(scene);
-        }
+        anim->setScene(scene);
     }
 }
 
 bool AnimationGroup::update(float dt) {
-    if (animations_.empty()) {
+    if (running_.empty()) {
         return false; // No animations to update
     }
     
-    // Update all animations and remove finished ones
-    animations_.erase(
-        std::remove_if(animations_.begin(), animations_.end(),
-            [dt](std::shared_ptr<Animation>& anim) {
-                return !anim->update(dt); // Remove if animation is finished
+    ThreadPool* pool = scene_ ? scene_->getUpdatePool() : nullptr;
+    if (pool && pool->size() > 1 && running_.size() >= kParallelMinAnimations) {
+        updateParallel(*pool, dt);
+        return !running_.empty();
+    }
+    
+    // Update all animations and remove finished ones, keeping group order
+    running_.erase(
+        std::remove_if(running_.begin(), running_.end(),
+            [this, dt](uint32_t index) {
+                return !animations_[index]->update(dt); // Remove if animation is finished
             }),
-        animations_.end()
+        running_.end()
     );
     
     // Return true if there are still animations running
-    return !animations_.empty();
+    return !running_.empty();
+}
+
+
+void AnimationGroup::updateParallel(ThreadPool& pool, float dt) {
+    // Animations without a single target (groups, schedules, AddToScene) may
+    // touch anything, so each runs alone, in order, between the parallel
+    // segments of targeted animations before and after it
+    const size_t count = running_.size();
+    finished_.assign(count, 0);
+    for (size_t begin = 0; begin < count;) {
+        size_t end = begin;
+        while (end < count && targets_[running_[end]]) ++end;
+        updateSegment(pool, begin, end, dt);
+        if (end < count) finished_[end] = !animations_[running_[end]]->update(dt);
+        begin = end + 1;
+    }
+    
+    // Remove finished animations, keeping group order
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!finished_[i]) running_[kept++] = running_[i];
+    }
+    running_.resize(kept);
+}
+
+void AnimationGroup::updateSegment(ThreadPool& pool, size_t begin, size_t end, float dt) {
+    if (end - begin < kParallelMinAnimations) {
+        for (size_t i = begin; i < end; ++i) finished_[i] = !animations_[running_[i]]->update(dt);
+        return;
+    }
+    
+    // Animations are bucketed by target, so each object's animations run in
+    // running order on one thread, as they would in a serial update
+    const uint32_t buckets = static_cast<uint32_t>(pool.size()) * 4;
+    auto bucketOf = [buckets](const Animatable* target) {
+        uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(target) >> 4) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>((h >> 32) % buckets);
+    };
+    
+    bucketStart_.assign(buckets + 1, 0);
+    for (size_t i = begin; i < end; ++i) ++bucketStart_[bucketOf(targets_[running_[i]]) + 1];
+    for (uint32_t b = 0; b < buckets; ++b) bucketStart_[b + 1] += bucketStart_[b];
+    order_.resize(end - begin);
+    // Fill back to front so each bucket keeps running order
+    for (size_t i = end; i-- > begin;) {
+        order_[--bucketStart_[bucketOf(targets_[running_[i]]) + 1]] = static_cast<uint32_t>(i);
+    }
+    // Filling moved each bucket's start down one slot
+    bucketStart_.erase(bucketStart_.begin());
+    bucketStart_.push_back(static_cast<uint32_t>(order_.size()));
+    
+    pool.parallelFor(static_cast<int>(buckets), [this, dt](int bucket) {
+        for (uint32_t k = bucketStart_[bucket]; k < bucketStart_[bucket + 1]; ++k) {
+            uint32_t position = order_[k];
+            finished_[position] = !animations_[running_[position]]->update(dt);
+        }
+    });
+}
+
+// Schedule implementation
+int Schedule::at(float time, std::shared_ptr<Animation> animation) {
+    entries_.push_back({std::move(animation), std::max(time, 0.0f), true});
+    tails_.push_back(static_cast<int>(entries_.size() - 1));
+    return static_cast<int>(tails_.size() - 1);
+}
+
+int Schedule::then(int track, std::shared_ptr<Animation> animation, float gap) {
+    if (track < 0 || track >= static_cast<int>(tails_.size())) return at(gap, std::move(animation));
+    entries_.push_back({std::move(animation), std::max(gap, 0.0f), false});
+    int entry = static_cast<int>(entries_.size() - 1);
+    entries_[tails_[track]].next = entry;
+    tails_[track] = entry;
+    return track;
+}
+
+void Schedule::start() {
+    // Buffers sized once, so updates do not allocate
+    pending_.clear();
+    pending_.reserve(entries_.size());
+    active_.clear();
+    active_.reserve(entries_.size());
+    chained_.clear();
+    chained_.reserve(entries_.size());
+    
+    // Queue the first entry of every track
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].first) pending_.push_back({entries_[i].offset, static_cast<uint32_t>(i)});
+    }
+    std::make_heap(pending_.begin(), pending_.end(), std::greater<Pending>());
+    time_ = 0.0f;
+    started_ = true;
+}
+
+bool Schedule::update(float dt) {
+    if (!started_) start();
+    time_ += dt;
+    
+    // Start everything due by the end of this step
+    while (!pending_.empty() && pending_.front().start <= time_) {
+        std::pop_heap(pending_.begin(), pending_.end(), std::greater<Pending>());
+        Pending due = pending_.back();
+        pending_.pop_back();
+        entries_[due.entry].startedAt = due.start;
+        active_.push_back(due.entry);
+    }
+    
+    // Entries started this step only run for the part of it after their start
+    for (size_t i = 0; i < active_.size();) {
+        Entry& entry = entries_[active_[i]];
+        float step = std::min(dt, time_ - entry.startedAt);
+        if (!entry.animation || !entry.animation->update(step)) {
+            if (entry.next >= 0) {
+                chained_.push_back({time_ + entries_[entry.next].offset, static_cast<uint32_t>(entry.next)});
+            }
+            active_[i] = active_.back();
+            active_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    
+    // Successors start from the next update on, like timeline actions
+    for (const auto& next : chained_) {
+        pending_.push_back(next);
+        std::push_heap(pending_.begin(), pending_.end(), std::greater<Pending>());
+    }
+    chained_.clear();
+    
+    return !active_.empty() || !pending_.empty();
+}
+
+void Schedule::reset() {
+    for (auto& entry : entries_) {
+        if (entry.animation) entry.animation->reset();
+    }
+    started_ = false;
 }
 
+void Schedule::setScene(Scene* scene) {
+    for (auto& entry : entries_) {
+        if (entry.animation) entry.animation->setScene(scene);
+    }
+}
+
+bool Schedule::compile(TweenTrack& track, float start) const {
+    // Chained entries start when the one before ends, which only running
+    // them tells
+    for (const auto& entry : entries_) {
+        if (entry.next >= 0) return false;
+    }
+    for (const auto& entry : entries_) {
+        if (entry.animation && !entry.animation->compile(track, start + entry.offset)) return false;
+    }
+    return true;
+}
+
+LaggedStart::LaggedStart(const std::vector<std::shared_ptr<Animation>>& animations, float lag) {
+    float time = 0.0f;
+    for (const auto& anim : animations) {
+        if (!anim) continue;
+        at(time, anim);
+        time += lag;
+    }
+}
 
 } // namespace banim
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "banim/arena.h"
+#include <cstdint>
+#include <new>
+
+namespace banim {
+
+namespace {
+
+constexpr size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+Arena::~Arena() {
+    // Every allocation holds the arena, so only empty slabs remain
+    if (current_) ::operator delete(current_, std::align_val_t(kSlabSize));
+    if (spare_) ::operator delete(spare_, std::align_val_t(kSlabSize));
+}
+
+Arena::Slab* Arena::newSlab() {
+    if (spare_) {
+        Slab* slab = spare_;
+        spare_ = nullptr;
+        return slab;
+    }
+    // Slabs are aligned to their size, so an allocation finds its slab by
+    // masking its address
+    void* memory = ::operator new(kSlabSize, std::align_val_t(kSlabSize));
+    ++slabCount_;
+    Slab* slab = new (memory) Slab();
+    slab->used = sizeof(Slab);
+    return slab;
+}
+
+void Arena::release(Slab* slab) {
+    slab->used = sizeof(Slab);
+    if (!spare_) {
+        spare_ = slab;
+    } else {
+        ::operator delete(slab, std::align_val_t(kSlabSize));
+        --slabCount_;
+    }
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    if (!small(bytes, alignment)) {
+        return ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t offset = current_ ? alignUp(current_->used, alignment) : kSlabSize;
+    if (offset + bytes > kSlabSize) {
+        // A full slab nothing lives in any more is reused in place; otherwise
+        // it is released when its last allocation is freed
+        if (current_ && current_->live == 0) {
+            current_->used = sizeof(Slab);
+        } else {
+            current_ = newSlab();
+        }
+        offset = alignUp(current_->used, alignment);
+    }
+    current_->used = offset + bytes;
+    ++current_->live;
+    return reinterpret_cast<char*>(current_) + offset;
+}
+
+void Arena::deallocate(void* p, size_t bytes, size_t alignment) {
+    if (!small(bytes, alignment)) {
+        ::operator delete(p, std::align_val_t(alignment));
+        return;
+    }
+
+    auto address = reinterpret_cast<uintptr_t>(p);
+    auto* slab = reinterpret_cast<Slab*>(address & ~static_cast<uintptr_t>(kSlabSize - 1));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--slab->live == 0 && slab != current_) release(slab);
+}
+
+void Arena::beginSegment() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!current_) return;
+    if (current_->live == 0) {
+        current_->used = sizeof(Slab);
+    } else {
+        current_ = nullptr;
+    }
+}
+
+size_t Arena::slabCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slabCount_;
+}
+
+} // namespace banim
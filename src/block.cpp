@@ -1,6 +1,6 @@
 #include "banim/block.h"
 #include "banim/scene.h"
-#include "banim/init.h"
+#include "banim/surface.h"
 #include <algorithm>
 #include <cmath>
 
@@ -22,22 +22,87 @@ Block::Block(const GridCoord& position, float gridWidth, float gridHeight,
     updatePortPositions();
 }
 
-void Block::draw(cairo_t* cr) {
-    // Draw the block background (use parent Rectangle drawing)
-    Rectangle::draw(cr);
-    
-    // Get grid-to-pixel conversion using current scene's grid config
-    if (!g_ctx) return;
+bool Block::detailed(const RenderContext& ctx) const {
+    return ctx.detailed(std::min(gridSize_.x * ctx.cellWidth, gridSize_.y * ctx.cellHeight));
+}
+
+const GlyphRun& Block::labelRun(const RenderContext& ctx, GlyphRun& scratch) const {
+    float size = labelSize_ * ctx.zoom;
+    if (labelRun_.matches(label_, "Arial", CAIRO_FONT_WEIGHT_BOLD, size)) return labelRun_;
+    scratch.update(label_, "Arial", CAIRO_FONT_WEIGHT_BOLD, size);
+    return scratch;
+}
+
+SpriteCache::Key Block::spriteKey(const RenderContext& ctx) const {
+    return {{gridSize_.x * ctx.cellWidth, gridSize_.y * ctx.cellHeight,
+             r_, g_, b_, rotation_, strokeWidth_, filled_ ? 1.0f : 0.0f, getBorderRadius()}};
+}
+
+SpriteCache::Key Block::overlayKey(const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
+    SpriteCache::Key key{{gridSize_.x * cellWidth, gridSize_.y * cellHeight,
+                          labelSize_ * ctx.zoom, labelR_, labelG_, labelB_, labelA_},
+                         label_};
+    for (const auto* ports : {&leftPorts_, &rightPorts_, &topPorts_, &bottomPorts_}) {
+        for (const auto& port : *ports) {
+            key.values.push_back((port.position.x - gridPos_.x) * cellWidth);
+            key.values.push_back((port.position.y - gridPos_.y) * cellHeight);
+        }
+    }
+    return key;
+}
+
+void Block::prepareDraw(const RenderContext& ctx) {
+    labelRun_.update(label_, "Arial", CAIRO_FONT_WEIGHT_BOLD, labelSize_ * ctx.zoom);
+    Animatable::prepareDraw(ctx);
+    if (!spriteCaching_) return;
     
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
+    // The body is rasterized opaque and faded when composited; the label and
+    // port dots do not fade with it, so they are cached separately
+    float anchorX = gridPos_.x * ctx.cellWidth;
+    float anchorY = gridPos_.y * ctx.cellHeight;
+    sprite_.update(spriteKey(ctx), Rectangle::getPixelBounds(ctx), anchorX, anchorY, ctx,
+                   [&](cairo_t* sprite) {
+                       DisplayList list;
+                       Rectangle::record(list, ctx, 1.0f);
+                       list.replay(sprite);
+                   });
+    if (!detailed(ctx)) return;
+    overlaySprite_.update(overlayKey(ctx), getPixelBounds(ctx), anchorX, anchorY, ctx,
+                          [&](cairo_t* sprite) {
+                              DisplayList list;
+                              recordOverlay(list, ctx);
+                              list.replay(sprite);
+                          });
+}
+
+void Block::draw(cairo_t* cr, const RenderContext& ctx) {
+    bool detail = detailed(ctx);
+    if (spriteCaching_ && sprite_.ready(spriteKey(ctx)) &&
+        (!detail || overlaySprite_.ready(overlayKey(ctx)))) {
+        float anchorX = gridPos_.x * ctx.cellWidth;
+        float anchorY = gridPos_.y * ctx.cellHeight;
+        sprite_.composite(cr, anchorX, anchorY, a_);
+        if (detail) overlaySprite_.composite(cr, anchorX, anchorY, 1.0f);
+        return;
+    }
+    Animatable::draw(cr, ctx);
+}
+
+void Block::record(DisplayList& list, const RenderContext& ctx, float alpha) const {
+    // Draw the block background (use parent Rectangle drawing)
+    Rectangle::record(list, ctx, alpha);
     
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
+    // Zoomed far out the label and ports would be unreadable specks
+    if (detailed(ctx)) recordOverlay(list, ctx);
+}
+
+void Block::recordOverlay(DisplayList& list, const RenderContext& ctx) const {
+    // Grid-to-pixel conversion for this frame
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     float pixelX = gridPos_.x * cellWidth;
     float pixelY = gridPos_.y * cellHeight;
@@ -46,58 +111,82 @@ void Block::draw(cairo_t* cr) {
     
     // Draw the label
     if (!label_.empty()) {
-        cairo_save(cr);
+        list.save();
         
         // Set text properties
-        cairo_set_source_rgba(cr, labelR_, labelG_, labelB_, labelA_);
-        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-        cairo_set_font_size(cr, labelSize_);
+        list.setSourceRgba(labelR_, labelG_, labelB_, labelA_);
         
         // Get text dimensions for centering
-        cairo_text_extents_t textExtents;
-        cairo_text_extents(cr, label_.c_str(), &textExtents);
+        GlyphRun scratch;
+        const GlyphRun& run = labelRun(ctx, scratch);
+        const cairo_text_extents_t& textExtents = run.extents();
         
         // Center the text in the block
         float textX = pixelX + (pixelW - textExtents.width) / 2.0f - textExtents.x_bearing;
         float textY = pixelY + (pixelH + textExtents.height) / 2.0f - textExtents.y_bearing;
         
-        cairo_move_to(cr, textX, textY);
-        cairo_show_text(cr, label_.c_str());
+        run.record(list, textX, textY);
         
-        cairo_restore(cr);
+        list.restore();
     }
     
-    // Draw port indicators (small circles)
-    cairo_save(cr);
-    cairo_set_source_rgba(cr, 0.8f, 0.8f, 0.8f, 1.0f);
-    
-    // Draw all ports
-    for (const auto& port : leftPorts_) {
-        float portPixelX = port.position.x * cellWidth;
-        float portPixelY = port.position.y * cellHeight;
-        cairo_arc(cr, portPixelX, portPixelY, 3.0f, 0, 2 * M_PI);
-        cairo_fill(cr);
-    }
-    for (const auto& port : rightPorts_) {
-        float portPixelX = port.position.x * cellWidth;
-        float portPixelY = port.position.y * cellHeight;
-        cairo_arc(cr, portPixelX, portPixelY, 3.0f, 0, 2 * M_PI);
-        cairo_fill(cr);
-    }
-    for (const auto& port : topPorts_) {
-        float portPixelX = port.position.x * cellWidth;
-        float portPixelY = port.position.y * cellHeight;
-        cairo_arc(cr, portPixelX, portPixelY, 3.0f, 0, 2 * M_PI);
-        cairo_fill(cr);
+    // Draw port indicators (small circles), all in one fill
+    list.save();
+    list.setSourceRgba(0.8f, 0.8f, 0.8f, 1.0f);
+    list.newPath();
+    for (const auto* ports : {&leftPorts_, &rightPorts_, &topPorts_, &bottomPorts_}) {
+        for (const auto& port : *ports) {
+            float portPixelX = port.position.x * cellWidth;
+            float portPixelY = port.position.y * cellHeight;
+            list.newSubPath();
+            list.arc(portPixelX, portPixelY, 3.0f, 0, 2 * M_PI);
+        }
     }
-    for (const auto& port : bottomPorts_) {
-        float portPixelX = port.position.x * cellWidth;
-        float portPixelY = port.position.y * cellHeight;
-        cairo_arc(cr, portPixelX, portPixelY, 3.0f, 0, 2 * M_PI);
-        cairo_fill(cr);
+    list.fill();
+    list.restore();
+}
+
+PixelRect Block::getPixelBounds(const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
+    PixelRect box = Rectangle::getPixelBounds(ctx);
+    
+    // Labels are centered on the block but may be wider than it
+    if (!label_.empty()) {
+        GlyphRun scratch;
+        const cairo_text_extents_t& extents = labelRun(ctx, scratch).extents();
+        float cx = (gridPos_.x + gridSize_.x * 0.5f) * cellWidth;
+        float cy = (gridPos_.y + gridSize_.y * 0.5f) * cellHeight;
+        float hw = static_cast<float>(extents.width) * 0.5f + 2.0f;
+        float hh = static_cast<float>(extents.height) * 0.5f + 2.0f;
+        box = box.united({cx - hw, cy - hh, cx + hw, cy + hh});
     }
     
-    cairo_restore(cr);
+    // Port dots (radius 3) sit on the edges
+    for (const auto* ports : {&leftPorts_, &rightPorts_, &topPorts_, &bottomPorts_}) {
+        for (const auto& port : *ports) {
+            float px = port.position.x * cellWidth;
+            float py = port.position.y * cellHeight;
+            box = box.united({px - 4.0f, py - 4.0f, px + 4.0f, py + 4.0f});
+        }
+    }
+    return box;
+}
+
+void Block::saveState(StateBuffer& state) const {
+    Rectangle::saveState(state);
+    state.write(label_);
+    state.write(labelSize_);
+    state.write(labelR_); state.write(labelG_); state.write(labelB_); state.write(labelA_);
+}
+
+void Block::restoreState(StateBuffer& state) {
+    Rectangle::restoreState(state);
+    label_ = state.readString();
+    labelSize_ = state.readFloat();
+    labelR_ = state.readFloat(); labelG_ = state.readFloat();
+    labelB_ = state.readFloat(); labelA_ = state.readFloat();
+    updatePortPositions();
 }
 
 void Block::addPort(PortDirection direction, const std::string& name) {
@@ -153,6 +242,7 @@ Port* Block::getPort(PortDirection direction, int index) {
 
 void Block::setLabel(const std::string& label) {
     label_ = label;
+    markDirty();
 }
 
 void Block::setLabelColor(float r, float g, float b, float a) {
@@ -160,6 +250,7 @@ void Block::setLabelColor(float r, float g, float b, float a) {
     labelG_ = g;
     labelB_ = b;
     labelA_ = a;
+    markDirty();
 }
 
 void Block::updatePortPositions() {
@@ -167,6 +258,8 @@ void Block::updatePortPositions() {
     updatePortsForDirection(rightPorts_, PortDirection::RIGHT);
     updatePortsForDirection(topPorts_, PortDirection::TOP);
     updatePortsForDirection(bottomPorts_, PortDirection::BOTTOM);
+    markDirty();
+    notifyPortsChanged();
 }
 
 void Block::updatePortsForDirection(std::vector<Port>& ports, PortDirection direction) {
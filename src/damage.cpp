@@ -0,0 +1,98 @@
+#include "banim/damage.h"
+#include <algorithm>
+#include <cmath>
+
+namespace banim {
+
+namespace {
+
+constexpr size_t kMaxDamageRects = 16;   // Collapse to a bounding box beyond this
+constexpr float kMergeDistance = 8.0f;   // Merge rects closer than this (pixels)
+constexpr float kFullRepaintRatio = 0.6f; // Repaint everything above this coverage
+
+} // namespace
+
+PixelRect PixelRect::united(const PixelRect& o) const {
+    if (empty()) return o;
+    if (o.empty()) return *this;
+    return {std::min(x0, o.x0), std::min(y0, o.y0), std::max(x1, o.x1), std::max(y1, o.y1)};
+}
+
+PixelRect PixelRect::intersected(const PixelRect& o) const {
+    PixelRect r{std::max(x0, o.x0), std::max(y0, o.y0), std::min(x1, o.x1), std::min(y1, o.y1)};
+    return r.empty() ? PixelRect() : r;
+}
+
+PixelRect PixelRect::rotated(float x, float y, float w, float h, float angle) {
+    float cx = x + w * 0.5f;
+    float cy = y + h * 0.5f;
+    float c = std::fabs(std::cos(angle));
+    float s = std::fabs(std::sin(angle));
+    float ex = (std::fabs(w) * c + std::fabs(h) * s) * 0.5f;
+    float ey = (std::fabs(w) * s + std::fabs(h) * c) * 0.5f;
+    return {cx - ex, cy - ey, cx + ex, cy + ey};
+}
+
+void DamageRegion::reset(int width, int height) {
+    rects_.clear();
+    width_ = width;
+    height_ = height;
+    full_ = false;
+}
+
+void DamageRegion::addFull() {
+    rects_.clear();
+    rects_.push_back({0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_)});
+    full_ = true;
+}
+
+void DamageRegion::add(const PixelRect& rect) {
+    if (full_) return;
+
+    // Snap outward to whole pixels and clip to the surface
+    PixelRect r{std::floor(rect.x0), std::floor(rect.y0), std::ceil(rect.x1), std::ceil(rect.y1)};
+    r = r.intersected({0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_)});
+    if (r.empty()) return;
+
+    rects_.push_back(r);
+    mergeOverlapping();
+
+    if (rects_.size() > kMaxDamageRects) {
+        PixelRect bounds;
+        for (const auto& d : rects_) bounds = bounds.united(d);
+        rects_.assign(1, bounds);
+    }
+
+    float covered = 0.0f;
+    for (const auto& d : rects_) covered += d.area();
+    if (covered >= kFullRepaintRatio * static_cast<float>(width_) * static_cast<float>(height_))
+        addFull();
+}
+
+bool DamageRegion::intersects(const PixelRect& rect) const {
+    for (const auto& d : rects_) {
+        if (d.intersects(rect)) return true;
+    }
+    return false;
+}
+
+void DamageRegion::mergeOverlapping() {
+    // Fold the newest rect into any neighbour it touches, repeating while merges cascade
+    PixelRect r = rects_.back();
+    rects_.pop_back();
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < rects_.size(); ++i) {
+            if (rects_[i].inflated(kMergeDistance).intersects(r)) {
+                r = r.united(rects_[i]);
+                rects_.erase(rects_.begin() + i);
+                merged = true;
+                break;
+            }
+        }
+    }
+    rects_.push_back(r);
+}
+
+} // namespace banim
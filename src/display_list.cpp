@@ -0,0 +1,155 @@
+#include "banim/display_list.h"
+#include "banim/path_batch.h"
+
+namespace banim {
+
+DisplayList::~DisplayList() { clear(); }
+
+void DisplayList::clear() {
+    commands_.clear();
+    glyphs_.clear();
+    for (auto* font : fonts_) cairo_scaled_font_destroy(font);
+    fonts_.clear();
+}
+
+void DisplayList::push(Op op, double a0, double a1, double a2, double a3, double a4, double a5) {
+    Command c;
+    c.op = op;
+    c.a[0] = static_cast<float>(a0);
+    c.a[1] = static_cast<float>(a1);
+    c.a[2] = static_cast<float>(a2);
+    c.a[3] = static_cast<float>(a3);
+    c.a[4] = static_cast<float>(a4);
+    c.a[5] = static_cast<float>(a5);
+    commands_.push_back(c);
+}
+
+void DisplayList::save() { push(Op::Save); }
+void DisplayList::restore() { push(Op::Restore); }
+void DisplayList::translate(double tx, double ty) { push(Op::Translate, tx, ty); }
+void DisplayList::rotate(double angle) { push(Op::Rotate, angle); }
+void DisplayList::scale(double sx, double sy) { push(Op::Scale, sx, sy); }
+void DisplayList::newPath() { push(Op::NewPath); }
+void DisplayList::newSubPath() { push(Op::NewSubPath); }
+void DisplayList::moveTo(double x, double y) { push(Op::MoveTo, x, y); }
+void DisplayList::lineTo(double x, double y) { push(Op::LineTo, x, y); }
+void DisplayList::curveTo(double x1, double y1, double x2, double y2, double x3, double y3) {
+    push(Op::CurveTo, x1, y1, x2, y2, x3, y3);
+}
+void DisplayList::arc(double xc, double yc, double radius, double angle1, double angle2) {
+    push(Op::Arc, xc, yc, radius, angle1, angle2);
+}
+void DisplayList::arcNegative(double xc, double yc, double radius, double angle1, double angle2) {
+    push(Op::ArcNegative, xc, yc, radius, angle1, angle2);
+}
+void DisplayList::rectangle(double x, double y, double width, double height) {
+    push(Op::Rectangle, x, y, width, height);
+}
+void DisplayList::closePath() { push(Op::ClosePath); }
+void DisplayList::setSourceRgba(double r, double g, double b, double a) {
+    push(Op::SetSource, r, g, b, a);
+}
+void DisplayList::setLineWidth(double width) { push(Op::SetLineWidth, width); }
+void DisplayList::fill() { push(Op::Fill); }
+void DisplayList::fillPreserve() { push(Op::FillPreserve); }
+void DisplayList::stroke() { push(Op::Stroke); }
+
+void DisplayList::showGlyphs(cairo_scaled_font_t* font, const cairo_glyph_t* glyphs, int count,
+                             double x, double y) {
+    if (count <= 0) return;
+    push(Op::ShowGlyphs, x, y);
+    Command& c = commands_.back();
+    c.first = static_cast<uint32_t>(glyphs_.size());
+    c.count = static_cast<uint32_t>(count);
+    c.font = static_cast<uint32_t>(fonts_.size());
+    glyphs_.insert(glyphs_.end(), glyphs, glyphs + count);
+    fonts_.push_back(cairo_scaled_font_reference(font));
+}
+
+void DisplayList::replayPath(cairo_t* cr, const Command& c) {
+    const float* a = c.a;
+    switch (c.op) {
+    case Op::Save: cairo_save(cr); break;
+    case Op::Restore: cairo_restore(cr); break;
+    case Op::Translate: cairo_translate(cr, a[0], a[1]); break;
+    case Op::Rotate: cairo_rotate(cr, a[0]); break;
+    case Op::Scale: cairo_scale(cr, a[0], a[1]); break;
+    case Op::NewPath: cairo_new_path(cr); break;
+    case Op::NewSubPath: cairo_new_sub_path(cr); break;
+    case Op::MoveTo: cairo_move_to(cr, a[0], a[1]); break;
+    case Op::LineTo: cairo_line_to(cr, a[0], a[1]); break;
+    case Op::CurveTo: cairo_curve_to(cr, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+    case Op::Arc: cairo_arc(cr, a[0], a[1], a[2], a[3], a[4]); break;
+    case Op::ArcNegative: cairo_arc_negative(cr, a[0], a[1], a[2], a[3], a[4]); break;
+    case Op::Rectangle: cairo_rectangle(cr, a[0], a[1], a[2], a[3]); break;
+    case Op::ClosePath: cairo_close_path(cr); break;
+    default: break;
+    }
+}
+
+void DisplayList::replay(cairo_t* cr) const {
+    for (const Command& c : commands_) {
+        const float* a = c.a;
+        switch (c.op) {
+        case Op::SetSource: cairo_set_source_rgba(cr, a[0], a[1], a[2], a[3]); break;
+        case Op::SetLineWidth: cairo_set_line_width(cr, a[0]); break;
+        case Op::Fill: cairo_fill(cr); break;
+        case Op::FillPreserve: cairo_fill_preserve(cr); break;
+        case Op::Stroke: cairo_stroke(cr); break;
+        case Op::ShowGlyphs:
+            cairo_save(cr);
+            cairo_translate(cr, a[0], a[1]);
+            cairo_set_scaled_font(cr, fonts_[c.font]);
+            cairo_show_glyphs(cr, glyphs_.data() + c.first, static_cast<int>(c.count));
+            cairo_restore(cr);
+            break;
+        default: replayPath(cr, c); break;
+        }
+    }
+}
+
+bool DisplayList::singlePaint(PathStyle& style) const {
+    bool hasSource = false, painted = false, scaled = false;
+    PathStyle found;
+    found.lineWidth = 2.0; // Cairo's default
+    for (const Command& c : commands_) {
+        // Anything but restore after the paint draws more
+        if (painted && c.op != Op::Restore) return false;
+        switch (c.op) {
+        case Op::SetSource:
+            found.r = c.a[0];
+            found.g = c.a[1];
+            found.b = c.a[2];
+            found.a = c.a[3];
+            hasSource = true;
+            break;
+        case Op::SetLineWidth: found.lineWidth = c.a[0]; break;
+        case Op::Scale: scaled = true; break;
+        case Op::Fill:
+        case Op::Stroke:
+            if (painted || !hasSource) return false;
+            // A batch strokes in pixels; a scaled pen would come out differently
+            if (c.op == Op::Stroke && scaled) return false;
+            found.fill = c.op == Op::Fill;
+            painted = true;
+            break;
+        case Op::FillPreserve:
+        case Op::ShowGlyphs:
+            return false;
+        default:
+            break;
+        }
+    }
+    if (!painted) return false;
+    style = found;
+    return true;
+}
+
+void DisplayList::appendPath(cairo_t* cr) const {
+    for (const Command& c : commands_) {
+        // The batch's path holds other objects' geometry too
+        if (c.op != Op::NewPath) replayPath(cr, c);
+    }
+}
+
+} // namespace banim
@@ -0,0 +1,138 @@
+#include "banim/frame_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace banim {
+
+const char *framePhaseName(FramePhase phase) {
+    switch (phase) {
+    case FramePhase::Update: return "update";
+    case FramePhase::Rasterize: return "raster";
+    case FramePhase::Upload: return "upload";
+    case FramePhase::Swap: return "swap";
+    default: return "?";
+    }
+}
+
+double FrameTiming::total() const {
+    double sum = 0.0;
+    for (double s : seconds) sum += s;
+    return sum;
+}
+
+FrameStats::FrameStats(size_t capacity) : ring_(std::max<size_t>(capacity, 1)) {}
+
+void FrameStats::push(const FrameTiming &timing) {
+    ring_[next_] = timing;
+    next_ = (next_ + 1) % ring_.size();
+    count_ = std::min(count_ + 1, ring_.size());
+}
+
+void FrameStats::clear() {
+    next_ = 0;
+    count_ = 0;
+}
+
+template <typename Fn> double FrameStats::percentileOf(double p, Fn value) const {
+    if (count_ == 0) return 0.0;
+    scratch_.clear();
+    for (size_t i = 0; i < count_; ++i) scratch_.push_back(value(ring_[i]));
+
+    // Nearest-rank percentile
+    double rank = std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(count_));
+    size_t k = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+    std::nth_element(scratch_.begin(), scratch_.begin() + k, scratch_.end());
+    return scratch_[k];
+}
+
+double FrameStats::percentile(FramePhase phase, double p) const {
+    return percentileOf(p, [phase](const FrameTiming &t) { return t[phase]; });
+}
+
+double FrameStats::totalPercentile(double p) const {
+    return percentileOf(p, [](const FrameTiming &t) { return t.total(); });
+}
+
+namespace {
+
+constexpr float kScaleStep = 0.85f;     // Ratio between resolution steps
+constexpr double kSmoothing = 0.2;      // Weight of the newest frame time
+constexpr double kStepDownAt = 0.9;     // Fraction of the budget
+constexpr double kStepUpBelow = 0.6;    // Predicted fraction of the budget
+constexpr int kSettleFrames = 15;       // Frames to measure before another change
+
+} // namespace
+
+ResolutionScaler::ResolutionScaler(double budgetSeconds, float minScale)
+    : budget_(budgetSeconds), minScale_(minScale) {}
+
+float ResolutionScaler::update(double rasterizeSeconds) {
+    average_ = average_ == 0.0 ? rasterizeSeconds
+                               : average_ + kSmoothing * (rasterizeSeconds - average_);
+    if (cooldown_ > 0) {
+        --cooldown_;
+        return scale_;
+    }
+
+    // Rasterize time follows the pixel count, the square of the scale
+    float next = scale_;
+    if (average_ > kStepDownAt * budget_ && scale_ > minScale_) {
+        next = std::max(scale_ * kScaleStep, minScale_);
+    } else if (scale_ < 1.0f) {
+        float up = std::min(scale_ / kScaleStep, 1.0f);
+        double ratio = static_cast<double>(up) / scale_;
+        if (average_ * ratio * ratio < kStepUpBelow * budget_)
+            next = up;
+    }
+    if (next != scale_) {
+        double ratio = static_cast<double>(next) / scale_;
+        average_ *= ratio * ratio;
+        scale_ = next;
+        cooldown_ = kSettleFrames;
+    }
+    return scale_;
+}
+
+void ResolutionScaler::reset() {
+    scale_ = 1.0f;
+    average_ = 0.0;
+    cooldown_ = 0;
+}
+
+PixelRect drawFrameStatsHud(cairo_t *cr, const FrameStats &stats, float x, float y) {
+    constexpr float kFontSize = 13.0f;
+    constexpr float kLineHeight = 16.0f;
+    constexpr float kPadding = 6.0f;
+    constexpr float kWidth = 190.0f;
+
+    char lines[kFramePhaseCount + 2][64];
+    std::snprintf(lines[0], sizeof lines[0], "%-7s %6s %6s", "ms", "p50", "p99");
+    for (int i = 0; i < kFramePhaseCount; ++i) {
+        FramePhase phase = static_cast<FramePhase>(i);
+        std::snprintf(lines[i + 1], sizeof lines[i + 1], "%-7s %6.2f %6.2f", framePhaseName(phase),
+                      stats.percentile(phase, 50) * 1000.0, stats.percentile(phase, 99) * 1000.0);
+    }
+    std::snprintf(lines[kFramePhaseCount + 1], sizeof lines[0], "%-7s %6.2f %6.2f", "frame",
+                  stats.totalPercentile(50) * 1000.0, stats.totalPercentile(99) * 1000.0);
+
+    const int lineCount = kFramePhaseCount + 2;
+    PixelRect area{x, y, x + kWidth, y + 2 * kPadding + lineCount * kLineHeight};
+
+    cairo_save(cr);
+    cairo_rectangle(cr, area.x0, area.y0, area.width(), area.height());
+    cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.7);
+    cairo_fill(cr);
+
+    cairo_select_font_face(cr, "monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, kFontSize);
+    cairo_set_source_rgba(cr, 0.9, 0.95, 0.9, 1.0);
+    for (int i = 0; i < lineCount; ++i) {
+        cairo_move_to(cr, x + kPadding, y + kPadding + (i + 1) * kLineHeight - 4.0f);
+        cairo_show_text(cr, lines[i]);
+    }
+    cairo_restore(cr);
+    return area;
+}
+
+} // namespace banim
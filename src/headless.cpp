@@ -0,0 +1,208 @@
+#include "banim/headless.h"
+#include "banim/thread_pool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace banim {
+
+namespace {
+
+// A run of consecutive frames copied out of a worker's surface
+struct FrameChunk {
+    std::vector<std::vector<unsigned char>> frames;
+    bool last = false; // Timeline drained inside (or before) this chunk
+};
+
+// Shared between the workers and the thread feeding the sink
+struct ChunkQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<int, FrameChunk> ready; // Finished chunks not yet written
+    int nextToWrite = 0;
+    bool stop = false;
+    std::exception_ptr error;
+};
+
+} // namespace
+
+int renderHeadless(Scene &scene, const HeadlessOptions &opt, const FrameSink &sink) {
+    if (opt.width <= 0 || opt.height <= 0 || opt.fps <= 0)
+        throw std::invalid_argument("renderHeadless: invalid size or fps");
+
+    CairoSurface target(opt.width, opt.height);
+
+    std::unique_ptr<ThreadPool> tilePool;
+    if (opt.tileThreads != 1)
+        tilePool = std::make_unique<ThreadPool>(opt.tileThreads);
+
+    // Hand the scene its own update pool back however the loop ends
+    struct RestorePool {
+        Scene &scene;
+        ThreadPool *pool;
+        ~RestorePool() { scene.setUpdatePool(pool); }
+    } restorePool{scene, scene.getUpdatePool()};
+    if (tilePool && !restorePool.pool)
+        scene.setUpdatePool(tilePool.get());
+
+    const float dt = 1.0f / static_cast<float>(opt.fps);
+    int frame = 0;
+    while (!scene.isFinished()) {
+        if (opt.maxFrames > 0 && frame >= opt.maxFrames)
+            break;
+        scene.update(dt);
+        if (tilePool)
+            rasterizeFrameTiled(scene, target, *tilePool, nullptr, opt.tileSize);
+        else
+            rasterizeFrame(scene, target);
+        if (sink)
+            sink(frame, target.surface());
+        ++frame;
+    }
+    return frame;
+}
+
+int renderParallel(const SceneBuilder &build, const ParallelOptions &opt,
+                   const FrameSink &sink) {
+    if (opt.width <= 0 || opt.height <= 0 || opt.fps <= 0 || opt.chunkFrames <= 0)
+        throw std::invalid_argument("renderParallel: invalid size, fps or chunk size");
+
+    int threads = opt.threads > 0 ? opt.threads
+                                  : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+    const int inFlight = opt.chunksInFlight > 0 ? opt.chunksInFlight : 2 * threads;
+    const int chunkFrames = opt.chunkFrames;
+    const int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, opt.width);
+    const size_t frameBytes = static_cast<size_t>(stride) * opt.height;
+    const float dt = 1.0f / static_cast<float>(opt.fps);
+
+    // Every worker gets its own copy of the scene state
+    std::vector<std::unique_ptr<Scene>> scenes;
+    for (int i = 0; i < threads; ++i) {
+        scenes.push_back(std::make_unique<Scene>());
+        scenes.back()->setSeekable(false);
+        build(*scenes.back());
+    }
+
+    ChunkQueue queue;
+
+    // Worker w renders chunks w, w + threads, w + 2 * threads, ...
+    auto worker = [&](int w) {
+        try {
+            Scene &scene = *scenes[w];
+            CairoSurface target(opt.width, opt.height);
+
+            int frame = 0; // Index of the next frame the scene will produce
+            auto canProduce = [&]() {
+                return !scene.isFinished() && (opt.maxFrames <= 0 || frame < opt.maxFrames);
+            };
+
+            for (int chunk = w;; chunk += threads) {
+                {
+                    std::unique_lock<std::mutex> lock(queue.mutex);
+                    queue.cv.wait(lock, [&] {
+                        return queue.stop || chunk < queue.nextToWrite + inFlight;
+                    });
+                    if (queue.stop)
+                        return;
+                }
+
+                // Fast-forward through chunks owned by other workers
+                const int start = chunk * chunkFrames;
+                while (frame < start && canProduce()) {
+                    scene.update(dt);
+                    ++frame;
+                }
+
+                FrameChunk out;
+                while (frame < start + chunkFrames && canProduce()) {
+                    scene.update(dt);
+                    rasterizeFrame(scene, target);
+                    const unsigned char *data = cairo_image_surface_get_data(target.surface());
+                    out.frames.emplace_back(data, data + frameBytes);
+                    ++frame;
+                }
+                out.last = frame < start + chunkFrames;
+
+                const bool last = out.last;
+                {
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    queue.ready.emplace(chunk, std::move(out));
+                }
+                queue.cv.notify_all();
+                if (last)
+                    return;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.error)
+                queue.error = std::current_exception();
+            queue.stop = true;
+            queue.cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int w = 0; w < threads; ++w)
+        pool.emplace_back(worker, w);
+
+    // Hand chunks to the sink strictly in timeline order
+    int written = 0;
+    try {
+        for (int chunk = 0;; ++chunk) {
+            FrameChunk current;
+            {
+                std::unique_lock<std::mutex> lock(queue.mutex);
+                queue.cv.wait(lock, [&] {
+                    return queue.error || queue.ready.count(chunk) > 0;
+                });
+                if (queue.error)
+                    break;
+                current = std::move(queue.ready[chunk]);
+                queue.ready.erase(chunk);
+            }
+
+            for (auto &pixels : current.frames) {
+                if (sink) {
+                    cairo_surface_t *frame = cairo_image_surface_create_for_data(
+                        pixels.data(), CAIRO_FORMAT_ARGB32, opt.width, opt.height, stride);
+                    sink(written, frame);
+                    cairo_surface_destroy(frame);
+                }
+                ++written;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.nextToWrite = chunk + 1;
+                if (current.last)
+                    queue.stop = true;
+            }
+            queue.cv.notify_all();
+            if (current.last)
+                break;
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.stop = true;
+        }
+        queue.cv.notify_all();
+        for (auto &t : pool)
+            t.join();
+        throw;
+    }
+
+    for (auto &t : pool)
+        t.join();
+    if (queue.error)
+        std::rethrow_exception(queue.error);
+    return written;
+}
+
+} // namespace banim
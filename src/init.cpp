@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -18,22 +19,46 @@
 namespace banim {
 
 GLContext *g_ctx = nullptr;
-CairoSurface *g_cairo = nullptr;
+Scene *g_currentScene = nullptr;
+CairoSurface *g_cairo = nullptr;       // Frame buffer when uploads copy
+PixelBufferRing *g_ring = nullptr;     // Frame buffers when they are GL-mapped
 Texture2D *g_tex = nullptr;
 Shader *g_shader = nullptr;
-Scene *g_currentScene = nullptr;  // For keyboard callbacks
 GLuint g_vao = 0, g_vbo = 0;
 
+// Frame timing HUD
+static FrameStats g_stats;
+static bool g_showStats = false;
+static PixelRect g_hudRect;   // Pixels the HUD covered last frame
+static float g_hudScale = 1.0f;
+
+// Dynamic resolution
+static ResolutionScaler *g_scaler = nullptr;
+static float g_shownScale = 1.0f; // Scale of the frame in the texture
+static GLint g_uvScaleLoc = -1, g_uvMaxLoc = -1;
+
+// Fixed-timestep updates run per frame at most, after a stall
+static constexpr int kMaxCatchUpSteps = 5;
+
+// Playback controls (see keyCallback)
+static bool g_paused = false;
+static float g_speed = 1.0f;
+static float g_frameStep = 1.0f / 60.0f; // Scene time of one frame in run()
+static float g_checkpointInterval = 2.0f;
+static constexpr float kMinSpeed = 0.125f;
+static constexpr float kMaxSpeed = 4.0f;   // Stays within the catch-up steps
+
 static const char *kVertShader = R"glsl(
 #version 120
 attribute vec2 aPos; attribute vec2 aUV; varying vec2 vUV;
-void main() { vUV = aUV; gl_Position = vec4(aPos, 0.0, 1.0); }
+uniform vec2 uUVScale; // Part of the texture holding the frame
+void main() { vUV = aUV * uUVScale; gl_Position = vec4(aPos, 0.0, 1.0); }
 )glsl";
 
 static const char *kFragShader = R"glsl(
 #version 120
-uniform sampler2D uTex; varying vec2 vUV;
-void main() { gl_FragColor = texture2D(uTex, vUV); }
+uniform sampler2D uTex; uniform vec2 uUVMax; varying vec2 vUV;
+void main() { gl_FragColor = texture2D(uTex, min(vUV, uUVMax)); }
 )glsl";
 
 GLContext::GLContext(int w, int h, const char *title, bool vsync)
@@ -71,7 +96,10 @@ void GLContext::framebufferResizeCallback(GLFWwindow *, int fw, int fh) {
     g_ctx->w_ = fw;
     g_ctx->h_ = fh;
     glViewport(0, 0, fw, fh);
-    g_cairo->recreate(fw, fh);
+    if (g_ring)
+        g_ring->resize(fw, fh);
+    else
+        g_cairo->recreate(fw, fh);
     g_tex->resize(fw, fh);
 }
 
@@ -80,33 +108,49 @@ void GLContext::keyCallback(GLFWwindow* window, int key, int scancode, int actio
         // Toggle grid display with 'G' key
         g_currentScene->displayGrid(!g_currentScene->isGridDisplayed());
     }
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+        // Toggle the frame timing HUD with 'H' key
+        showFrameStats(!g_showStats);
+    }
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
-}
-
-CairoSurface::CairoSurface(int w, int h) { recreate(w, h); }
-CairoSurface::~CairoSurface() {
-    if (cr_)
-        cairo_destroy(cr_);
-    if (surf_)
-        cairo_surface_destroy(surf_);
-}
-void CairoSurface::recreate(int w, int h) {
-    if (cr_) {
-        cairo_destroy(cr_);
-        cr_ = nullptr;
-    }
-    if (surf_) {
-        cairo_surface_destroy(surf_);
-        surf_ = nullptr;
+    
+    // Playback; seeking and stepping repeat while the key is held
+    Scene* scene = g_currentScene;
+    if (!scene || (action != GLFW_PRESS && action != GLFW_REPEAT)) return;
+    float seekBy = (mods & GLFW_MOD_SHIFT) ? 10.0f : 1.0f;
+    switch (key) {
+    case GLFW_KEY_SPACE:
+        if (action == GLFW_PRESS) g_paused = !g_paused;
+        break;
+    case GLFW_KEY_RIGHT:
+        scene->seek(scene->getTime() + seekBy, g_frameStep);
+        break;
+    case GLFW_KEY_LEFT:
+        scene->seek(scene->getTime() - seekBy, g_frameStep);
+        break;
+    case GLFW_KEY_PERIOD:
+        g_paused = true;
+        scene->seek(scene->getTime() + g_frameStep, g_frameStep);
+        break;
+    case GLFW_KEY_COMMA:
+        g_paused = true;
+        scene->seek(scene->getTime() - g_frameStep, g_frameStep);
+        break;
+    case GLFW_KEY_HOME:
+        scene->seek(0.0f, g_frameStep);
+        break;
+    case GLFW_KEY_UP:
+        g_speed = std::min(g_speed * 2.0f, kMaxSpeed);
+        break;
+    case GLFW_KEY_DOWN:
+        g_speed = std::max(g_speed * 0.5f, kMinSpeed);
+        break;
+    case GLFW_KEY_0:
+        g_speed = 1.0f;
+        break;
     }
-    surf_ = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
-    if (cairo_surface_status(surf_) != CAIRO_STATUS_SUCCESS)
-        throw std::runtime_error("Cairo surface creation failed");
-    cr_ = cairo_create(surf_);
-    if (cairo_status(cr_) != CAIRO_STATUS_SUCCESS)
-        throw std::runtime_error("Cairo context creation failed");
 }
 
 Texture2D::Texture2D(int w, int h) : tex_w_(w), tex_h_(h) {
@@ -141,26 +185,171 @@ void Texture2D::resize(int w, int h) {
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
     glBufferData(GL_PIXEL_UNPACK_BUFFER, w * h * 4, nullptr, GL_STREAM_DRAW);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    needsFullUpload_ = true;
 }
-void Texture2D::upload(const cairo_surface_t *surf) {
-    int stride = cairo_image_surface_get_stride((cairo_surface_t *)surf);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+void Texture2D::upload(const cairo_surface_t *surf, const DamageRegion *damage) {
+    cairo_surface_t *src = const_cast<cairo_surface_t *>(surf);
+    int stride = cairo_image_surface_get_stride(src);
+    const unsigned char *pixels = cairo_image_surface_get_data(src);
+    size_t bytes = static_cast<size_t>(stride) * tex_h_;
+    bool partial = damage && !damage->isFull() && !needsFullUpload_;
+
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, tex_w_ * tex_h_ * 4, nullptr,
-                 GL_STREAM_DRAW);
-    void *ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-    memcpy(ptr, cairo_image_surface_get_data((cairo_surface_t *)surf),
-           tex_w_ * tex_h_ * 4);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    unsigned char *ptr =
+        static_cast<unsigned char *>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+
+    if (!partial) {
+        memcpy(ptr, pixels, bytes);
+    } else {
+        // Stage only the dirty rows at their natural offsets, then upload
+        // each rectangle from the same buffer layout
+        for (const auto &r : damage->rects()) {
+            int x = static_cast<int>(r.x0), y = static_cast<int>(r.y0);
+            int w = static_cast<int>(r.width()), h = static_cast<int>(r.height());
+            for (int row = y; row < y + h; ++row) {
+                size_t offset = static_cast<size_t>(row) * stride + static_cast<size_t>(x) * 4;
+                memcpy(ptr + offset, pixels + offset, static_cast<size_t>(w) * 4);
+            }
+        }
+    }
     glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-    glBindTexture(GL_TEXTURE_2D, tex_);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex_w_, tex_h_, GL_BGRA,
-                    GL_UNSIGNED_BYTE, nullptr);
+    transfer(stride, partial, damage);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+void Texture2D::uploadFrom(GLuint pbo, int stride, const DamageRegion *damage) {
+    bool partial = damage && !damage->isFull() && !needsFullUpload_;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    transfer(stride, partial, damage);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+void Texture2D::transfer(int stride, bool partial, const DamageRegion *damage) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+    glBindTexture(GL_TEXTURE_2D, tex_);
+
+    if (!partial) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex_w_, tex_h_, GL_BGRA,
+                        GL_UNSIGNED_BYTE, nullptr);
+        needsFullUpload_ = false;
+    } else {
+        for (const auto &r : damage->rects()) {
+            int x = static_cast<int>(r.x0), y = static_cast<int>(r.y0);
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, static_cast<int>(r.width()),
+                            static_cast<int>(r.height()), GL_BGRA, GL_UNSIGNED_BYTE,
+                            nullptr);
+        }
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    }
+
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
+// Block until the GL has finished with the buffer fence guards, then delete
+// the fence. glClientWaitSync takes a real timeout, so wait in slices.
+static void waitForFence(GLsync &fence) {
+    constexpr GLuint64 kWaitSliceNs = 100000000; // 100 ms
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;) {
+        GLenum result = glClientWaitSync(fence, flags, kWaitSliceNs);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            break;
+        if (result == GL_WAIT_FAILED) {
+            // Cannot wait on the fence; make sure the GL is done some other way
+            std::cerr << "glClientWaitSync failed, waiting with glFinish" << std::endl;
+            glFinish();
+            break;
+        }
+        flags = 0; // GL_TIMEOUT_EXPIRED: commands were flushed by the first attempt
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+bool PixelBufferRing::supported() {
+    return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+PixelBufferRing::PixelBufferRing(int w, int h, int count) : slots_(count) {
+    allocate(w, h);
+}
+PixelBufferRing::~PixelBufferRing() { release(); }
+void PixelBufferRing::resize(int w, int h) {
+    release();
+    allocate(w, h);
+}
+void PixelBufferRing::allocate(int w, int h) {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    w_ = w;
+    h_ = h;
+    stride_ = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w);
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(stride_) * h;
+    for (auto &slot : slots_) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags);
+        void *data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags);
+        if (!data)
+            throw std::runtime_error("Failed to map pixel buffer");
+        slot.surface.reset(new CairoSurface(static_cast<unsigned char *>(data), w, h, stride_));
+        slot.stale.reset(w, h);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    current_ = -1;
+}
+void PixelBufferRing::release() {
+    for (auto &slot : slots_) {
+        if (slot.fence) {
+            // The GL may still be reading the buffer
+            waitForFence(slot.fence);
+        }
+        slot.surface.reset();
+        if (slot.pbo) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+CairoSurface &PixelBufferRing::acquire(Scene &scene) {
+    current_ = (current_ + 1) % static_cast<int>(slots_.size());
+    Slot &slot = slots_[current_];
+    if (slot.fence)
+        waitForFence(slot.fence);
+
+    if (slot.stale.isFull()) {
+        slot.surface->setHasContent(false);
+    } else {
+        for (const auto &r : slot.stale.rects())
+            scene.invalidate(r);
+    }
+    slot.stale.reset(w_, h_);
+    return *slot.surface;
+}
+void PixelBufferRing::submit(Texture2D &tex, const DamageRegion &damage) {
+    Slot &slot = slots_[current_];
+    tex.uploadFrom(slot.pbo, stride_, &damage);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // damage is in surface pixels; the other slots catch up in scene pixels
+    float scale = slot.surface->scale();
+    for (auto &other : slots_) {
+        if (&other == &slot)
+            continue;
+        if (damage.isFull()) {
+            other.stale.addFull();
+        } else {
+            for (const auto &r : damage.rects())
+                other.stale.add({r.x0 / scale, r.y0 / scale, r.x1 / scale, r.y1 / scale});
+        }
+    }
+}
+
 Shader::Shader(const char *vsrc, const char *fsrc) {
     GLuint vs = compile(GL_VERTEX_SHADER, vsrc);
     GLuint fs = compile(GL_FRAGMENT_SHADER, fsrc);
@@ -199,9 +388,18 @@ GLuint Shader::compile(GLenum t, const char *src) {
 bool init(const InitOptions &opt) {
     try {
         g_ctx = new GLContext(opt.width, opt.height, opt.title, opt.vsync);
-        g_cairo = new CairoSurface(opt.width, opt.height);
+        if (opt.zeroCopyUpload && PixelBufferRing::supported())
+            g_ring = new PixelBufferRing(opt.width, opt.height);
+        else
+            g_cairo = new CairoSurface(opt.width, opt.height);
+        g_showStats = opt.showStats;
         g_tex = new Texture2D(opt.width, opt.height);
         g_shader = new Shader(kVertShader, kFragShader);
+        g_uvScaleLoc = glGetUniformLocation(g_shader->id(), "uUVScale");
+        g_uvMaxLoc = glGetUniformLocation(g_shader->id(), "uUVMax");
+        if (opt.dynamicResolution)
+            g_scaler = new ResolutionScaler(1.0 / 60.0, opt.minResolutionScale);
+        g_checkpointInterval = opt.checkpointInterval;
         float quad[] = {-1, -1, 0, 1, 1, -1, 1, 1, 1, 1, 1, 0, -1, 1, 0, 0};
         glGenVertexArrays(1, &g_vao);
         glGenBuffers(1, &g_vbo);
@@ -226,16 +424,70 @@ bool init(const InitOptions &opt) {
     return true;
 }
 
-void renderFrame(Scene &scene) {
-    cairo_t *cr = g_cairo->context();
-    // Use dark background for better contrast with educational content
-    cairo_set_source_rgb(cr, 0.1, 0.1, 0.15);  // Dark blue-gray background
-    cairo_paint(cr);
-    scene.renderScene(cr);
-    cairo_surface_flush(g_cairo->surface());
-    g_tex->upload(g_cairo->surface());
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void renderFrame(Scene &scene, FrameTiming *timing) {
+    using clock = std::chrono::steady_clock;
+    FrameTiming local;
+    FrameTiming &t = timing ? *timing : local;
+
+    auto start = clock::now();
+    CairoSurface &target = g_ring ? g_ring->acquire(scene) : *g_cairo;
+    DamageRegion damage;
+    target.setScale(g_scaler ? g_scaler->scale() : 1.0f);
+    rasterizeFrame(scene, target, &damage);
+    if (damage.empty() && target.scale() != 1.0f) {
+        // The scene went idle: redraw the still frame at full resolution
+        g_scaler->reset();
+        target.setScale(1.0f);
+        rasterizeFrame(scene, target, &damage);
+    }
+    if (!g_hudRect.empty()) {
+        // The HUD is drawn over the scene unscaled; repaint what it covered
+        // (in scene pixels). This is a separate pass so that the HUD does not
+        // count as scene damage and keep the idle test above from firing.
+        scene.invalidate({g_hudRect.x0 / g_hudScale, g_hudRect.y0 / g_hudScale,
+                          g_hudRect.x1 / g_hudScale, g_hudRect.y1 / g_hudScale});
+        g_hudRect = PixelRect();
+        DamageRegion hudDamage;
+        rasterizeFrame(scene, target, &hudDamage);
+        if (hudDamage.isFull()) {
+            damage.addFull();
+        } else {
+            for (const auto &r : hudDamage.rects())
+                damage.add(r);
+        }
+    }
+    if (g_showStats) {
+        g_hudRect = drawFrameStatsHud(target.context(), g_stats, 8.0f, 8.0f);
+        g_hudScale = target.scale();
+        cairo_surface_flush(target.surface());
+        damage.add(g_hudRect);
+    }
+    t[FramePhase::Rasterize] = secondsSince(start);
+    if (g_scaler && !damage.empty())
+        g_scaler->update(t[FramePhase::Rasterize]);
+
+    start = clock::now();
+    if (!damage.empty()) {
+        if (g_ring)
+            g_ring->submit(*g_tex, damage);
+        else
+            g_tex->upload(target.surface(), &damage);
+        g_shownScale = target.scale();
+    }
+    t[FramePhase::Upload] = secondsSince(start);
+
+    start = clock::now();
     glClear(GL_COLOR_BUFFER_BIT);
     g_shader->use();
+    // Stretch the frame's part of the texture over the window, without
+    // sampling past its last texel
+    glUniform2f(g_uvScaleLoc, g_shownScale, g_shownScale);
+    glUniform2f(g_uvMaxLoc, g_shownScale - 0.5f / g_ctx->width(),
+                g_shownScale - 0.5f / g_ctx->height());
     glBindVertexArray(g_vao);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, g_tex->id());
@@ -243,13 +495,24 @@ void renderFrame(Scene &scene) {
     glBindVertexArray(0);
     glfwSwapBuffers(g_ctx->window());
     glfwPollEvents();
+    t[FramePhase::Swap] = secondsSince(start);
 }
 
+const FrameStats &frameStats() { return g_stats; }
+
+float resolutionScale() { return g_shownScale; }
+
+void showFrameStats(bool show) { g_showStats = show; }
+
 void cleanup() {
+    delete g_scaler;
+    g_scaler = nullptr;
     delete g_shader;
     g_shader = nullptr;
     delete g_tex;
     g_tex = nullptr;
+    delete g_ring;
+    g_ring = nullptr;
     delete g_cairo;
     g_cairo = nullptr;
     delete g_ctx;
@@ -262,28 +525,59 @@ void cleanup() {
 
 void run(Scene& scene, bool fixedTimestep /*= true*/, int fps /*= 60*/) {
     g_currentScene = &scene;  // Set global scene for keyboard callbacks
+    scene.setCheckpointInterval(g_checkpointInterval);
+    
+    using clock = std::chrono::steady_clock;
+    const auto step = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / static_cast<double>(fps)));
+    const float dt = 1.0f / static_cast<float>(fps);
     
-    using clock = std::chrono::high_resolution_clock;
     auto last = clock::now();
-    double dt = 1.0 / static_cast<double>(fps);
+    auto deadline = last + step;
+    clock::duration accumulator{0};
+    g_stats.clear();
+    if (g_scaler)
+        g_scaler->setBudget(1.0 / fps);
+    g_frameStep = dt;
 
     while (!glfwWindowShouldClose(g_ctx->window())) {
         auto now = clock::now();
-        std::chrono::duration<double> elapsed = now - last;
-
-        if (fixedTimestep) {
-            if (elapsed.count() >= dt) {
-                scene.update(static_cast<float>(dt));
-                renderFrame(scene);
-                last = now;
-            } else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        auto elapsed = now - last;
+        last = now;
+        
+        FrameTiming timing;
+        if (g_paused) {
+            accumulator = clock::duration{0};
+        } else if (fixedTimestep) {
+            // Whole steps of simulated time; after a stall only a bounded
+            // number are replayed and the rest of the backlog is dropped.
+            // The playback speed scales how fast the steps come, not dt.
+            accumulator += std::chrono::duration_cast<clock::duration>(elapsed * g_speed);
+            int steps = 0;
+            while (accumulator >= step && steps < kMaxCatchUpSteps) {
+                scene.update(dt);
+                accumulator -= step;
+                ++steps;
             }
+            if (accumulator >= step)
+                accumulator = accumulator % step;
+        } else {
+            double seconds = std::chrono::duration<double>(elapsed).count() * g_speed;
+            scene.update(static_cast<float>(std::min(seconds, kMaxCatchUpSteps * static_cast<double>(dt))));
+        }
+        timing[FramePhase::Update] = secondsSince(now);
+        
+        renderFrame(scene, &timing);
+        g_stats.push(timing);
+
+        // Sleep until the next frame is due; after an overrun, start pacing
+        // again from now instead of rushing to catch up
+        auto after = clock::now();
+        if (deadline > after) {
+            std::this_thread::sleep_until(deadline);
+            deadline += step;
         } else {
-            last = now;
-            scene.update(static_cast<float>(elapsed.count()));
-            renderFrame(scene);
-            std::this_thread::sleep_for(std::chrono::duration<double>(dt));
+            deadline = after + step;
         }
     }
     
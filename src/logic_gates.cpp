@@ -1,6 +1,6 @@
 #include "banim/logic_gates.h"
 #include "banim/scene.h"
-#include "banim/init.h"
+#include "banim/surface.h"
 #include <cmath>
 #include <algorithm>
 
@@ -105,6 +105,7 @@ void LogicGate::clearAllPorts() {
     rightPorts_.clear();
     topPorts_.clear();
     bottomPorts_.clear();
+    updatePortPositions();
 }
 
 std::vector<Port>& LogicGate::getPorts(PortDirection direction) {
@@ -159,6 +160,8 @@ void LogicGate::updatePortPositions() {
     updatePortsForDirection(getPorts(PortDirection::RIGHT), PortDirection::RIGHT);
     updatePortsForDirection(getPorts(PortDirection::TOP), PortDirection::TOP);
     updatePortsForDirection(getPorts(PortDirection::BOTTOM), PortDirection::BOTTOM);
+    markDirty();
+    notifyPortsChanged();
 }
 
 void LogicGate::updatePortsForDirection(std::vector<Port>& ports, PortDirection direction) {
@@ -226,22 +229,52 @@ void LogicGate::setGateColor(float r, float g, float b, float a) {
 
 void LogicGate::setSymbolColor(float r, float g, float b, float a) {
     symbolR_ = r; symbolG_ = g; symbolB_ = b; symbolA_ = a;
+    markDirty();
 }
 
-void LogicGate::draw(cairo_t* cr) {
-    // Get pixel coordinates and size
-    extern GLContext* g_ctx;
-    if (!g_ctx) return;
-    
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
-    
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
+void LogicGate::saveState(StateBuffer& state) const {
+    Rectangle::saveState(state);
+    state.write(gateR_); state.write(gateG_); state.write(gateB_); state.write(gateA_);
+    state.write(symbolR_); state.write(symbolG_); state.write(symbolB_); state.write(symbolA_);
+}
+
+void LogicGate::restoreState(StateBuffer& state) {
+    Rectangle::restoreState(state);
+    gateR_ = state.readFloat(); gateG_ = state.readFloat();
+    gateB_ = state.readFloat(); gateA_ = state.readFloat();
+    symbolR_ = state.readFloat(); symbolG_ = state.readFloat();
+    symbolB_ = state.readFloat(); symbolA_ = state.readFloat();
+    updatePortPositions();
+}
+
+PixelRect LogicGate::getPixelBounds(const RenderContext& ctx) const {
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
+    float pixelW = gridSize_.x * cellWidth;
+    float pixelH = gridSize_.y * cellHeight;
+    PixelRect box{gridPos_.x * cellWidth, gridPos_.y * cellHeight,
+                  gridPos_.x * cellWidth + pixelW, gridPos_.y * cellHeight + pixelH};
     
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
+    // OR/XOR bodies reach 10% past the input edge and inversion bubbles sit
+    // just past the output edge, in whichever direction the gate faces
+    float overhang = std::max(std::fabs(pixelW), std::fabs(pixelH)) * 0.15f;
+    return box.inflated(overhang + 2.0f);
+}
+
+void LogicGate::prepareDraw(const RenderContext& ctx) {
+    // Gate shapes are not sprite cached: the Rectangle sprite key does not
+    // know the gate type or facing
+    Animatable::prepareDraw(ctx);
+}
+
+void LogicGate::draw(cairo_t* cr, const RenderContext& ctx) {
+    Animatable::draw(cr, ctx);
+}
+
+void LogicGate::record(DisplayList& list, const RenderContext& ctx, float alpha) const {
+    // Get pixel coordinates and size
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     // Use the same coordinate system as Rectangle
     float pixelX = gridPos_.x * cellWidth;
@@ -249,9 +282,19 @@ void LogicGate::draw(cairo_t* cr) {
     float pixelW = gridSize_.x * cellWidth;
     float pixelH = gridSize_.y * cellHeight;
     
+    // Too small on screen to tell gate types apart: a plain box in the gate color
+    if (!ctx.detailed(std::min(std::fabs(pixelW), std::fabs(pixelH)))) {
+        list.save();
+        list.setSourceRgba(gateR_, gateG_, gateB_, gateA_ * alpha);
+        list.rectangle(pixelX, pixelY, pixelW, pixelH);
+        list.fill();
+        list.restore();
+        return;
+    }
+    
     // Set up drawing context - gates fill the entire grid cell
-    cairo_save(cr);
-    cairo_translate(cr, pixelX, pixelY);
+    list.save();
+    list.translate(pixelX, pixelY);
     
     // Use the full grid cell size
     float gateWidth = pixelW;
@@ -264,165 +307,165 @@ void LogicGate::draw(cairo_t* cr) {
             break;
         case PortDirection::LEFT:
             // Rotate 180 degrees
-            cairo_translate(cr, gateWidth / 2, gateHeight / 2);
-            cairo_rotate(cr, M_PI);
-            cairo_translate(cr, -gateWidth / 2, -gateHeight / 2);
+            list.translate(gateWidth / 2, gateHeight / 2);
+            list.rotate(M_PI);
+            list.translate(-gateWidth / 2, -gateHeight / 2);
             break;
         case PortDirection::TOP:
             // Rotate 90 degrees counter-clockwise
-            cairo_translate(cr, gateWidth / 2, gateHeight / 2);
-            cairo_rotate(cr, -M_PI_2);
-            cairo_translate(cr, -gateHeight / 2, -gateWidth / 2);
+            list.translate(gateWidth / 2, gateHeight / 2);
+            list.rotate(-M_PI_2);
+            list.translate(-gateHeight / 2, -gateWidth / 2);
             // Swap width and height for vertical orientation
             std::swap(gateWidth, gateHeight);
             break;
         case PortDirection::BOTTOM:
             // Rotate 90 degrees clockwise
-            cairo_translate(cr, gateWidth / 2, gateHeight / 2);
-            cairo_rotate(cr, M_PI_2);
-            cairo_translate(cr, -gateHeight / 2, -gateWidth / 2);
+            list.translate(gateWidth / 2, gateHeight / 2);
+            list.rotate(M_PI_2);
+            list.translate(-gateHeight / 2, -gateWidth / 2);
             // Swap width and height for vertical orientation
             std::swap(gateWidth, gateHeight);
             break;
     }
     
     // Set colors and style - use inherited alpha for animations like Rectangle does
-    cairo_set_source_rgba(cr, gateR_, gateG_, gateB_, gateA_ * a_);
-    cairo_set_line_width(cr, 2.0f);
+    list.setSourceRgba(gateR_, gateG_, gateB_, gateA_ * alpha);
+    list.setLineWidth(2.0f);
     
     // Draw the appropriate gate shape
     switch (gateType_) {
         case GateType::AND:
-            drawAndGate(cr, gateWidth, gateHeight);
+            drawAndGate(list, gateWidth, gateHeight);
             break;
         case GateType::OR:
-            drawOrGate(cr, gateWidth, gateHeight);
+            drawOrGate(list, gateWidth, gateHeight);
             break;
         case GateType::XOR:
-            drawXorGate(cr, gateWidth, gateHeight);
+            drawXorGate(list, gateWidth, gateHeight);
             break;
         case GateType::NOT:
-            drawNotGate(cr, gateWidth, gateHeight);
+            drawNotGate(list, gateWidth, gateHeight, alpha);
             break;
         case GateType::NAND:
-            drawAndGate(cr, gateWidth, gateHeight);
-            drawInversionBubble(cr, gateWidth, gateHeight);
+            drawAndGate(list, gateWidth, gateHeight);
+            drawInversionBubble(list, gateWidth, gateHeight, alpha);
             break;
         case GateType::NOR:
-            drawOrGate(cr, gateWidth, gateHeight);
-            drawInversionBubble(cr, gateWidth, gateHeight);
+            drawOrGate(list, gateWidth, gateHeight);
+            drawInversionBubble(list, gateWidth, gateHeight, alpha);
             break;
         case GateType::XNOR:
-            drawXorGate(cr, gateWidth, gateHeight);
-            drawInversionBubble(cr, gateWidth, gateHeight);
+            drawXorGate(list, gateWidth, gateHeight);
+            drawInversionBubble(list, gateWidth, gateHeight, alpha);
             break;
     }
     
-    cairo_restore(cr);
+    list.restore();
 }
 
-void LogicGate::drawAndGate(cairo_t* cr, float width, float height) {
+void LogicGate::drawAndGate(DisplayList& list, float width, float height) const {
     // Draw AND gate shape - rectangle on left, semicircle on right
     // Make sure the semicircle doesn't extend beyond the gate width
     float radius = height * 0.5f;
     float rectWidth = width - radius;  // Rectangle width = total width minus semicircle radius
     
-    cairo_move_to(cr, 0, 0);
-    cairo_line_to(cr, rectWidth, 0);
-    cairo_arc(cr, rectWidth, height * 0.5f, radius, -M_PI_2, M_PI_2);
-    cairo_line_to(cr, 0, height);
-    cairo_line_to(cr, 0, 0);
+    list.moveTo(0, 0);
+    list.lineTo(rectWidth, 0);
+    list.arc(rectWidth, height * 0.5f, radius, -M_PI_2, M_PI_2);
+    list.lineTo(0, height);
+    list.lineTo(0, 0);
     
-    if (filled_) cairo_fill(cr);
-    else cairo_stroke(cr);
+    if (filled_) list.fill();
+    else list.stroke();
 }
 
-void LogicGate::drawOrGate(cairo_t* cr, float width, float height) {
+void LogicGate::drawOrGate(DisplayList& list, float width, float height) const {
     // Draw OR gate shape - extend only to the left, stay within grid on the right
     float gateWidth = width * 1.1f;  // Make gate 10% wider
     float offsetX = -width * 0.1f;   // Shift left by 10% so it extends only leftward
     
-    cairo_save(cr);
-    cairo_translate(cr, offsetX, 0);
+    list.save();
+    list.translate(offsetX, 0);
     
-    cairo_move_to(cr, 0, 0);
-    cairo_curve_to(cr, gateWidth * 0.3f, 0, gateWidth * 0.7f, 0, gateWidth, height * 0.5f);
-    cairo_curve_to(cr, gateWidth * 0.7f, height, gateWidth * 0.3f, height, 0, height);
-    cairo_curve_to(cr, gateWidth * 0.2f, height * 0.7f, gateWidth * 0.2f, height * 0.3f, 0, 0);
+    list.moveTo(0, 0);
+    list.curveTo(gateWidth * 0.3f, 0, gateWidth * 0.7f, 0, gateWidth, height * 0.5f);
+    list.curveTo(gateWidth * 0.7f, height, gateWidth * 0.3f, height, 0, height);
+    list.curveTo(gateWidth * 0.2f, height * 0.7f, gateWidth * 0.2f, height * 0.3f, 0, 0);
     
-    if (filled_) cairo_fill(cr);
-    else cairo_stroke(cr);
+    if (filled_) list.fill();
+    else list.stroke();
     
-    cairo_restore(cr);
+    list.restore();
 }
 
-void LogicGate::drawXorGate(cairo_t* cr, float width, float height) {
+void LogicGate::drawXorGate(DisplayList& list, float width, float height) const {
     // Draw XOR gate shape - extend only to the left, stay within grid on the right
     float gateWidth = width * 1.05f;  // Make gate 5% wider
     float offsetX = -width * 0.05f;   // Shift left by 5% so it extends only leftward
     
-    cairo_save(cr);
-    cairo_translate(cr, offsetX, 0);
+    list.save();
+    list.translate(offsetX, 0);
     
     // Draw the main OR gate shape (shifted right slightly)
-    cairo_save(cr);
-    cairo_translate(cr, gateWidth * 0.1f, 0);
+    list.save();
+    list.translate(gateWidth * 0.1f, 0);
     
     // Draw main OR shape
     float mainGateWidth = gateWidth * 0.9f;
-    cairo_move_to(cr, 0, 0);
-    cairo_curve_to(cr, mainGateWidth * 0.3f, 0, mainGateWidth * 0.7f, 0, mainGateWidth, height * 0.5f);
-    cairo_curve_to(cr, mainGateWidth * 0.7f, height, mainGateWidth * 0.3f, height, 0, height);
-    cairo_curve_to(cr, mainGateWidth * 0.2f, height * 0.7f, mainGateWidth * 0.2f, height * 0.3f, 0, 0);
+    list.moveTo(0, 0);
+    list.curveTo(mainGateWidth * 0.3f, 0, mainGateWidth * 0.7f, 0, mainGateWidth, height * 0.5f);
+    list.curveTo(mainGateWidth * 0.7f, height, mainGateWidth * 0.3f, height, 0, height);
+    list.curveTo(mainGateWidth * 0.2f, height * 0.7f, mainGateWidth * 0.2f, height * 0.3f, 0, 0);
     
-    if (filled_) cairo_fill(cr);
-    else cairo_stroke(cr);
-    cairo_restore(cr);
+    if (filled_) list.fill();
+    else list.stroke();
+    list.restore();
     
     // Draw the additional curved line for XOR
-    cairo_move_to(cr, 0, height * 0.2f);
-    cairo_curve_to(cr,
+    list.moveTo(0, height * 0.2f);
+    list.curveTo(
         gateWidth * 0.15f, height * 0.35f,
         gateWidth * 0.15f, height * 0.65f,
         0, height * 0.8f);
-    cairo_stroke(cr);
+    list.stroke();
     
-    cairo_restore(cr);
+    list.restore();
 }
 
-void LogicGate::drawNotGate(cairo_t* cr, float width, float height) {
+void LogicGate::drawNotGate(DisplayList& list, float width, float height, float alpha) const {
     // Draw NOT gate (triangle)
-    cairo_move_to(cr, 0, 0);
-    cairo_line_to(cr, width * 0.8f, height * 0.5f);
-    cairo_line_to(cr, 0, height);
-    cairo_line_to(cr, 0, 0);
-    if (filled_) cairo_fill(cr);
-    else cairo_stroke(cr);
+    list.moveTo(0, 0);
+    list.lineTo(width * 0.8f, height * 0.5f);
+    list.lineTo(0, height);
+    list.lineTo(0, 0);
+    if (filled_) list.fill();
+    else list.stroke();
     
     // Add inverter circle
-    cairo_arc(cr, width * 0.9f, height * 0.5f, height * 0.1f, 0, 2 * M_PI);
+    list.arc(width * 0.9f, height * 0.5f, height * 0.1f, 0, 2 * M_PI);
     if (filled_) {
-        cairo_set_source_rgba(cr, 1.0f, 1.0f, 1.0f, 1.0f); // White fill for bubble
-        cairo_fill_preserve(cr);
-        cairo_set_source_rgba(cr, gateR_, gateG_, gateB_, gateA_ * a_); // Restore gate color
+        list.setSourceRgba(1.0f, 1.0f, 1.0f, 1.0f); // White fill for bubble
+        list.fillPreserve();
+        list.setSourceRgba(gateR_, gateG_, gateB_, gateA_ * alpha); // Restore gate color
     }
-    cairo_stroke(cr);
+    list.stroke();
 }
 
-void LogicGate::drawInversionBubble(cairo_t* cr, float width, float height) {
+void LogicGate::drawInversionBubble(DisplayList& list, float width, float height, float alpha) const {
     // Draw inversion bubble at the output - simple positioning at the right edge
     float bubbleRadius = height * 0.08f;
     float bubbleX = width;  // Near the right edge
     float bubbleY = height * 0.5f;  // Centered vertically
     
-    cairo_arc(cr, bubbleX, bubbleY, bubbleRadius, 0, 2 * M_PI);
+    list.arc(bubbleX, bubbleY, bubbleRadius, 0, 2 * M_PI);
     
     if (filled_) {
-        cairo_set_source_rgba(cr, 1.0f, 1.0f, 1.0f, 1.0f); // White fill for bubble
-        cairo_fill_preserve(cr);
-        cairo_set_source_rgba(cr, gateR_, gateG_, gateB_, gateA_ * a_); // Restore gate color
+        list.setSourceRgba(1.0f, 1.0f, 1.0f, 1.0f); // White fill for bubble
+        list.fillPreserve();
+        list.setSourceRgba(gateR_, gateG_, gateB_, gateA_ * alpha); // Restore gate color
     }
-    cairo_stroke(cr);
+    list.stroke();
 }
 
 std::string LogicGate::getGateSymbol() const {
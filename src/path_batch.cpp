@@ -0,0 +1,116 @@
+#include "banim/path_batch.h"
+#include "banim/animatable.h"
+#include <cfloat>
+#include <utility>
+
+namespace banim {
+
+namespace {
+
+constexpr size_t kMaxOpenBatches = 8; // Oldest batch is flushed beyond this
+constexpr size_t kMaxAreaBoxes = 8;    // Boxes tracking a batch's footprint
+
+} // namespace
+
+bool PathBatcher::Batch::overlaps(const PixelRect& bounds) const {
+    for (const auto& box : area) {
+        if (box.intersects(bounds)) return true;
+    }
+    return false;
+}
+
+void PathBatcher::Batch::cover(const PixelRect& bounds) {
+    // Grow the box that grows least, once there are enough boxes
+    if (area.size() < kMaxAreaBoxes) {
+        area.push_back(bounds);
+        return;
+    }
+    size_t best = 0;
+    float bestGrowth = FLT_MAX;
+    for (size_t i = 0; i < area.size(); ++i) {
+        float growth = area[i].united(bounds).area() - area[i].area();
+        if (growth < bestGrowth) {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    area[best] = area[best].united(bounds);
+}
+
+PixelRect PathBatcher::anything() {
+    return {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX};
+}
+
+void PathBatcher::draw(Animatable& object, const PixelRect& bounds) {
+    PathStyle style;
+    if (!object.pathStyle(ctx_, style)) {
+        flushOverlapping(bounds, -1);
+        object.draw(cr_, ctx_);
+        return;
+    }
+
+    int index = -1;
+    if (style.a >= 1.0f) {
+        for (size_t i = 0; i < open_.size(); ++i) {
+            if (open_[i].style == style) {
+                index = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+    index = flushOverlapping(bounds, index);
+
+    if (index < 0) {
+        if (open_.size() >= kMaxOpenBatches) {
+            submit(open_.front());
+            open_.erase(open_.begin());
+        }
+        open_.push_back({style, {}, {}});
+        index = static_cast<int>(open_.size()) - 1;
+    }
+    Batch& batch = open_[index];
+    batch.cover(bounds);
+    batch.objects.push_back(&object);
+
+    if (style.a < 1.0f) {
+        submit(batch);
+        open_.pop_back();
+    }
+}
+
+void PathBatcher::flush() {
+    for (const auto& batch : open_) submit(batch);
+    open_.clear();
+}
+
+int PathBatcher::flushOverlapping(const PixelRect& bounds, int keep) {
+    int kept = 0;
+    int keptIndex = -1;
+    for (int i = 0; i < static_cast<int>(open_.size()); ++i) {
+        if (i != keep && open_[i].overlaps(bounds)) {
+            submit(open_[i]);
+            continue;
+        }
+        if (i == keep) keptIndex = kept;
+        if (kept != i) open_[kept] = std::move(open_[i]);
+        ++kept;
+    }
+    open_.resize(kept);
+    return keptIndex;
+}
+
+void PathBatcher::submit(const Batch& batch) {
+    cairo_save(cr_);
+    cairo_new_path(cr_);
+    for (const Animatable* object : batch.objects) object->appendPath(cr_, ctx_);
+    cairo_set_source_rgba(cr_, batch.style.r, batch.style.g, batch.style.b, batch.style.a);
+    if (batch.style.fill) {
+        cairo_fill(cr_);
+    } else {
+        cairo_set_line_width(cr_, batch.style.lineWidth);
+        cairo_stroke(cr_);
+    }
+    cairo_restore(cr_);
+}
+
+} // namespace banim
@@ -2,158 +2,456 @@
 #include "banim/animatable.h"
 #include "banim/animations.h"
 #include "banim/init.h"
+#include "banim/surface.h"
+#include "banim/tween_track.h"
 #include <algorithm>
 #include <cmath>
 
 namespace banim {
 
+    // Frames an object stays in the live layer after its last change, so a
+    // multi-step animation does not rebake the static layer between steps
+    static constexpr int kLiveHoldFrames = 30;
+
+    Camera Scene::getCamera() const {
+        if (cameraSet_) return camera_;
+        return Camera(GridCoord((gridConfig_.cols - 1) * 0.5f, (gridConfig_.rows - 1) * 0.5f));
+    }
+    
+    RenderContext Scene::renderContext(int width, int height) const {
+        // Object positions are cell-centered, the context works on grid lines
+        Camera camera = getCamera();
+        return {width, height, gridConfig_.cols, gridConfig_.rows,
+                camera.center.x + 0.5f, camera.center.y + 0.5f, camera.zoom, quality_};
+    }
+
     std::pair<float, float> Scene::gridToPixel(const GridCoord& coord) const {
         return gridToPixel(coord.x, coord.y);
     }
     
+    bool Scene::layoutSize(int& width, int& height) const {
+        if (damageWidth_ > 0 && damageHeight_ > 0) {
+            width = damageWidth_;
+            height = damageHeight_;
+            return true;
+        }
+        // Not rendered yet (e.g. while the scene is being built): lay out
+        // for the window
+        if (g_ctx && g_ctx->width() > 0 && g_ctx->height() > 0) {
+            width = g_ctx->width();
+            height = g_ctx->height();
+            return true;
+        }
+        return false;
+    }
+    
     std::pair<float, float> Scene::gridToPixel(float gridX, float gridY) const {
-        if (!g_ctx) return {0, 0};
+        int width, height;
+        if (!layoutSize(width, height)) return {0, 0};
         
-        float windowWidth = static_cast<float>(g_ctx->width());
-        float windowHeight = static_cast<float>(g_ctx->height());
-        
-        float cellWidth = windowWidth / gridConfig_.cols;
-        float cellHeight = windowHeight / gridConfig_.rows;
+        RenderContext ctx = renderContext(width, height);
         
         // Grid coordinates are centered in cells
-        float pixelX = (gridX + 0.5f) * cellWidth;
-        float pixelY = (gridY + 0.5f) * cellHeight;
+        float pixelX = ctx.originX + (gridX + 0.5f) * ctx.cellWidth;
+        float pixelY = ctx.originY + (gridY + 0.5f) * ctx.cellHeight;
         
         return {pixelX, pixelY};
     }
     
     std::pair<float, float> Scene::getGridCellSize() const {
-        if (!g_ctx) return {50, 50}; // Default fallback
-        
-        float windowWidth = static_cast<float>(g_ctx->width());
-        float windowHeight = static_cast<float>(g_ctx->height());
+        int width, height;
+        if (!layoutSize(width, height)) return {50, 50}; // Default fallback
         
-        return {windowWidth / gridConfig_.cols, windowHeight / gridConfig_.rows};
+        RenderContext ctx = renderContext(width, height);
+        return {ctx.cellWidth, ctx.cellHeight};
     }
     
-    void Scene::drawGrid(cairo_t *cr) const {
-        if (!gridConfig_.displayGrid || !g_ctx) return;
-        
-        float windowWidth = static_cast<float>(g_ctx->width());
-        float windowHeight = static_cast<float>(g_ctx->height());
+    // Grid lines only need re-rasterizing when their geometry or style changes
+    static bool sameGridLines(const GridConfig& a, const GridConfig& b) {
+        return a.cols == b.cols && a.rows == b.rows && a.lineWidth == b.lineWidth &&
+               a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+
+    void Scene::updateGridCache(const RenderContext& ctx) const {
+        if (!gridConfig_.displayGrid) return;
         
-        float cellWidth = windowWidth / gridConfig_.cols;
-        float cellHeight = windowHeight / gridConfig_.rows;
+        if (!gridCache_ || gridCacheWidth_ != ctx.width || gridCacheHeight_ != ctx.height ||
+            gridCacheAntialias_ != ctx.quality.antialias ||
+            gridCacheCellWidth_ != ctx.cellWidth || gridCacheCellHeight_ != ctx.cellHeight ||
+            gridCacheOriginX_ != ctx.originX || gridCacheOriginY_ != ctx.originY ||
+            !sameGridLines(gridCacheConfig_, gridConfig_)) {
+            rebuildGridCache(ctx);
+        }
+    }
+
+    void Scene::drawGrid(cairo_t *cr, const RenderContext& ctx) const {
+        if (!gridConfig_.displayGrid) return;
+        updateGridCache(ctx);
         
+        // Composite the cached lines in one operation
         cairo_save(cr);
+        cairo_set_source_surface(cr, gridCache_.get(), 0, 0);
+        cairo_paint(cr);
+        cairo_restore(cr);
+    }
+
+    void Scene::rebuildGridCache(const RenderContext& ctx) const {
+        gridCache_.reset(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ctx.width, ctx.height));
+        gridCacheWidth_ = ctx.width;
+        gridCacheHeight_ = ctx.height;
+        gridCacheAntialias_ = ctx.quality.antialias;
+        gridCacheCellWidth_ = ctx.cellWidth;
+        gridCacheCellHeight_ = ctx.cellHeight;
+        gridCacheOriginX_ = ctx.originX;
+        gridCacheOriginY_ = ctx.originY;
+        gridCacheConfig_ = gridConfig_;
+        
+        float cellWidth = ctx.cellWidth;
+        float cellHeight = ctx.cellHeight;
+        
+        // Lines span the grid, wherever the camera puts it
+        float left = ctx.originX;
+        float top = ctx.originY;
+        float right = left + gridConfig_.cols * cellWidth;
+        float bottom = top + gridConfig_.rows * cellHeight;
+        
+        cairo_t *cr = cairo_create(gridCache_.get());
+        cairo_set_antialias(cr, ctx.quality.antialias);
         cairo_set_source_rgba(cr, gridConfig_.r, gridConfig_.g, gridConfig_.b, gridConfig_.a);
         cairo_set_line_width(cr, gridConfig_.lineWidth);
         
-        // Draw vertical lines
+        // All lines go into one path and are stroked once
         for (int i = 0; i <= gridConfig_.cols; ++i) {
-            float x = i * cellWidth;
-            cairo_move_to(cr, x, 0);
-            cairo_line_to(cr, x, windowHeight);
-            cairo_stroke(cr);
+            float x = left + i * cellWidth;
+            cairo_move_to(cr, x, top);
+            cairo_line_to(cr, x, bottom);
         }
-        
-        // Draw horizontal lines
         for (int i = 0; i <= gridConfig_.rows; ++i) {
-            float y = i * cellHeight;
-            cairo_move_to(cr, 0, y);
-            cairo_line_to(cr, windowWidth, y);
-            cairo_stroke(cr);
+            float y = top + i * cellHeight;
+            cairo_move_to(cr, left, y);
+            cairo_line_to(cr, right, y);
         }
+        cairo_stroke(cr);
         
-        cairo_restore(cr);
+        cairo_destroy(cr);
+        cairo_surface_flush(gridCache_.get());
     }
 
     void Scene::play(std::shared_ptr<Animation> anim) {
-        timeline_.push(anim);
+        timeline_.push_back(anim);
     }
     
     void Scene::playGroup(const std::vector<std::shared_ptr<Animation>>& animations) {
         if (animations.empty()) return;
         
-        auto group = std::make_shared<AnimationGroup>();
+        // A group of plain tweens runs as one compiled track
+        auto track = make<TweenTrack>();
+        bool compiled = std::all_of(animations.begin(), animations.end(),
+            [&track](const std::shared_ptr<Animation>& anim) { return !anim || anim->compile(*track, 0.0f); });
+        if (compiled) {
+            timeline_.push_back(track);
+            return;
+        }
+        
+        auto group = make<AnimationGroup>();
         group->addAll(animations);
-        timeline_.push(group);
+        timeline_.push_back(group);
+    }
+    
+    void Scene::playLagged(const std::vector<std::shared_ptr<Animation>>& animations, float lag) {
+        if (animations.empty()) return;
+        
+        auto lagged = make<LaggedStart>(animations, lag);
+        auto track = make<TweenTrack>();
+        if (lagged->compile(*track, 0.0f)) {
+            timeline_.push_back(track);
+        } else {
+            timeline_.push_back(lagged);
+        }
     }
     
     void Scene::addAnimatable(std::shared_ptr<Animatable> animatable) {
+        track(animatable);
         animatables_.push_back(animatable);
     }
     
     void Scene::clear() {
         // Queue a clear action in the timeline instead of clearing immediately
         ClearAction clearAction;
-        timeline_.push(clearAction);
+        timeline_.push_back(clearAction);
+        arena_->beginSegment();
     }
     
     void Scene::wait(float duration) {
-        timeline_.push(std::make_shared<Wait>(duration));
+        timeline_.push_back(make<Wait>(duration));
     }    
 
     void Scene::add(std::shared_ptr<Animatable> animatable) {
         // Create default PopIn animation and queue for timeline
-        auto popIn = std::make_shared<PopIn>(animatable, 0.5f);
+        auto popIn = make<PopIn>(animatable, 0.5f);
         AddAction action{animatable, popIn};
-        timeline_.push(action);
+        track(animatable);
+        timeline_.push_back(action);
     }
 
     void Scene::add(std::shared_ptr<Animatable> animatable, std::shared_ptr<Animation> animation) {
         AddAction action{animatable, animation};
-        timeline_.push(action);
+        track(animatable);
+        timeline_.push_back(action);
+    }
+
+    void Scene::collectDamage(int width, int height, DamageRegion& damage) {
+        damage.reset(width, height);
+        for (const auto& rect : pendingDamage_) damage.add(rect);
+        pendingDamage_.clear();
+        cameraMoving_ = cameraMoved_;
+        cameraMoved_ = false;
+        
+        if (width != damageWidth_ || height != damageHeight_) {
+            damageWidth_ = width;
+            damageHeight_ = height;
+            fullDamage_ = true;
+        }
+        
+        RenderContext ctx = renderContext(width, height);
+        
+        drawStates_.resize(animatables_.size());
+        for (size_t i = 0; i < animatables_.size(); ++i) {
+            Animatable& animatable = *animatables_[i];
+            DrawState& state = drawStates_[i];
+            
+            animatable.syncGeometry();
+            if (!animatable.isDirty() && state.hasBounds && !fullDamage_) {
+                if (state.idleFrames < kLiveHoldFrames) ++state.idleFrames;
+                continue;
+            }
+            if (animatable.isDirty() || !state.hasBounds) state.idleFrames = 0;
+            
+            PixelRect bounds = animatable.getPixelBounds(ctx).translated(ctx.originX, ctx.originY);
+            if (state.hasBounds) {
+                damage.add(state.bounds);
+                spatialIndex_.update(static_cast<int>(i), state.bounds, bounds);
+            } else {
+                spatialIndex_.insert(static_cast<int>(i), bounds);
+            }
+            damage.add(bounds);
+            state.bounds = bounds;
+            state.hasBounds = true;
+            animatable.clearDirty();
+        }
+        
+        if (fullDamage_) {
+            damage.addFull();
+            fullDamage_ = false;
+            staticLayerValid_ = false;
+        }
+        boundsCurrent_ = true;
     }
 
-    void Scene::renderScene(cairo_t *cr) {
-        // Draw grid first (behind everything)
-        drawGrid(cr);
+    bool Scene::updateLayers(const RenderContext& ctx) {
+        if (!staticLayerEnabled_ || !boundsCurrent_ || drawStates_.size() != animatables_.size())
+            return false;
+        
+        // Every pixel of the layer would change again next frame; it is baked
+        // once the camera comes to rest
+        if (cameraMoving_) return false;
+        
+        // Live objects: recently changed, plus anything above one of them in
+        // z-order that overlaps it, so the blit never draws over a live object
+        // that should be on top.
+        DamageRegion liveArea(damageWidth_, damageHeight_);
+        bool anyLive = false;
+        
+        // Only the parts of the layer where an object joins or leaves it are
+        // baked again: objects leaving are erased where they were baked,
+        // objects joining are drawn in at their bounds
+        DamageRegion bake(damageWidth_, damageHeight_);
+        if (!staticLayerValid_) bake.addFull();
+        for (auto& state : drawStates_) {
+            bool live = state.idleFrames < kLiveHoldFrames ||
+                        (anyLive && liveArea.intersects(state.bounds));
+            if (live) {
+                liveArea.add(state.bounds);
+                anyLive = true;
+            }
+            if (live && !state.live && state.inLayer) bake.add(state.layerBounds);
+            if (!live && state.live) bake.add(state.bounds);
+            state.live = live;
+            state.inLayer = !live;
+            if (!live) state.layerBounds = state.bounds;
+        }
         
-        // Draw all animatable objects
-        for (auto &animatable : animatables_) {
-            animatable->draw(cr);
+        if (!staticLayer_ ||
+            cairo_image_surface_get_width(staticLayer_.get()) != damageWidth_ ||
+            cairo_image_surface_get_height(staticLayer_.get()) != damageHeight_) {
+            staticLayer_.reset(cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                          damageWidth_, damageHeight_));
+            bake.addFull();
         }
+        
+        if (!bake.empty()) bakeStaticLayer(ctx, bake);
+        return true;
+    }
+
+    void Scene::bakeStaticLayer(const RenderContext& ctx, const DamageRegion& region) {
+        cairo_t *layer = cairo_create(staticLayer_.get());
+        PixelRect area;
+        for (const auto& r : region.rects()) {
+            area = area.united(r);
+            cairo_rectangle(layer, r.x0, r.y0, r.width(), r.height());
+        }
+        cairo_clip(layer);
+        cairo_set_operator(layer, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(layer);
+        cairo_set_operator(layer, CAIRO_OPERATOR_OVER);
+        cairo_set_antialias(layer, ctx.quality.antialias);
+        
+        drawGrid(layer, ctx);
+        
+        // Only static objects in the baked region, drawn through the camera
+        std::vector<int> visible;
+        spatialIndex_.query(area, visible);
+        cairo_translate(layer, ctx.originX, ctx.originY);
+        PathBatcher batch(layer, ctx);
+        for (int i : visible) {
+            const DrawState& state = drawStates_[i];
+            if (state.live || !region.intersects(state.bounds)) continue;
+            animatables_[i]->prepareDraw(ctx);
+            batch.draw(*animatables_[i], state.bounds);
+        }
+        batch.flush();
+        
+        cairo_destroy(layer);
+        cairo_surface_flush(staticLayer_.get());
+        staticLayerValid_ = true;
+    }
+
+    void Scene::renderScene(cairo_t *cr, const RenderContext& ctx) {
+        double x0, y0, x1, y1;
+        cairo_clip_extents(cr, &x0, &y0, &x1, &y1);
+        prepareRender(ctx, {static_cast<float>(x0), static_cast<float>(y0),
+                            static_cast<float>(x1), static_cast<float>(y1)});
+        drawPrepared(cr, ctx);
+        finishRender();
+    }
+
+    void Scene::prepareRender(const RenderContext& ctx, const PixelRect& clip) {
+        layered_ = updateLayers(ctx);
+        if (!layered_) updateGridCache(ctx);
+        
+        // With fresh bounds, only objects overlapping the clip are drawn,
+        // found through the spatial index
+        cull_ = boundsCurrent_ && drawStates_.size() == animatables_.size();
+        if (!cull_) {
+            for (auto& animatable : animatables_) {
+                animatable->syncGeometry();
+                animatable->prepareDraw(ctx);
+            }
+            return;
+        }
+        
+        std::vector<int> visible;
+        spatialIndex_.query(clip, visible);
+        for (int i : visible) {
+            const DrawState& state = drawStates_[i];
+            if ((layered_ && !state.live) || !state.bounds.intersects(clip)) continue;
+            animatables_[i]->syncGeometry();
+            animatables_[i]->prepareDraw(ctx);
+        }
+    }
+
+    void Scene::drawPrepared(cairo_t *cr, const RenderContext& ctx) const {
+        cairo_set_antialias(cr, ctx.quality.antialias);
+        if (layered_) {
+            // Grid and static objects in one blit
+            cairo_save(cr);
+            cairo_set_source_surface(cr, staticLayer_.get(), 0, 0);
+            cairo_paint(cr);
+            cairo_restore(cr);
+        } else {
+            // Draw grid first (behind everything)
+            drawGrid(cr, ctx);
+        }
+        
+        // Objects draw in scene pixels; bounds and clip are target pixels
+        cairo_save(cr);
+        if (!cull_) {
+            // Draw all animatable objects; without bounds only neighbours batch
+            cairo_translate(cr, ctx.originX, ctx.originY);
+            PathBatcher batch(cr, ctx);
+            for (const auto& animatable : animatables_) batch.draw(*animatable, PathBatcher::anything());
+            batch.flush();
+            cairo_restore(cr);
+            return;
+        }
+        
+        // Only objects overlapping this context's clip, in z-order
+        double x0, y0, x1, y1;
+        cairo_clip_extents(cr, &x0, &y0, &x1, &y1);
+        PixelRect clip{static_cast<float>(x0), static_cast<float>(y0),
+                       static_cast<float>(x1), static_cast<float>(y1)};
+        std::vector<int> visible;
+        spatialIndex_.query(clip, visible);
+        cairo_translate(cr, ctx.originX, ctx.originY);
+        PathBatcher batch(cr, ctx);
+        for (int i : visible) {
+            const DrawState& state = drawStates_[i];
+            if ((layered_ && !state.live) || !state.bounds.intersects(clip)) continue;
+            batch.draw(*animatables_[i], state.bounds);
+        }
+        batch.flush();
+        cairo_restore(cr);
+    }
+
+    void Scene::finishRender() {
+        boundsCurrent_ = false;
     }
 
     void Scene::update(float dt) {
+        if (isFinished()) return;
+        
         // Process timeline if no current animation
-        if (!currentAnimation_ && !timeline_.empty()) {
-            auto action = timeline_.front();
-            timeline_.pop();
+        if (!currentAnimation_ && timelineIndex_ < timeline_.size()) {
+            if (seekable_ && (checkpoints_.empty() ||
+                (checkpointInterval_ > 0 && time_ >= checkpoints_.back().time + checkpointInterval_))) {
+                saveCheckpoint();
+            }
+            // The timeline keeps its actions for seeking, so they are read in
+            // place rather than copied
+            const TimelineAction& action = timeline_[timelineIndex_++];
             
             // Check if this is an animation, animatable addition, or clear action
-            if (std::holds_alternative<std::shared_ptr<Animation>>(action)) {
-                // It's an animation
-                currentAnimation_ = std::get<std::shared_ptr<Animation>>(action);
-                
-                // Check if this is an AddToScene animation and set scene reference
-                auto addToScene = std::dynamic_pointer_cast<AddToScene>(currentAnimation_);
-                if (addToScene) {
-                    addToScene->setScene(this);
-                }
-                
-                // Check if this is an AnimationGroup and set scene for any AddToScene animations within
-                auto animGroup = std::dynamic_pointer_cast<AnimationGroup>(currentAnimation_);
-                if (animGroup) {
-                    animGroup->setScene(this);
-                }
-            } else if (std::holds_alternative<AddAction>(action)) {
+            if (const auto* animation = std::get_if<std::shared_ptr<Animation>>(&action)) {
+                // It's an animation; AddToScene animations, also inside
+                // groups, need the scene to add to
+                currentAnimation_ = animation->get();
+                if (currentAnimation_) currentAnimation_->setScene(this);
+            } else if (const auto* addAction = std::get_if<AddAction>(&action)) {
                 // It's an animatable addition
-                auto addAction = std::get<AddAction>(action);
                 
                 // Add animatable to the scene
-                animatables_.push_back(addAction.animatable);
+                animatables_.push_back(addAction->animatable);
                 
                 // If there's a spawn animation, start it
-                if (addAction.spawnAnimation) {
-                    addAction.animatable->hide(); // Hide initially
-                    currentAnimation_ = addAction.spawnAnimation;
+                if (addAction->spawnAnimation) {
+                    addAction->animatable->hide(); // Hide initially
+                    currentAnimation_ = addAction->spawnAnimation.get();
                 }
                 // If no spawn animation, animatable is immediately visible
             } else if (std::holds_alternative<ClearAction>(action)) {
                 // It's a clear action - clear all animatables
                 animatables_.clear();
+                drawStates_.clear();
+                spatialIndex_.clear();
+                fullDamage_ = true;
+                staticLayerValid_ = false;
+                
+                // Without seeking nothing before the clear plays again, so
+                // its actions are dropped and their arena slabs freed
+                if (!seekable_) {
+                    timeline_.erase(timeline_.begin(), timeline_.begin() + timelineIndex_);
+                    timelineIndex_ = 0;
+                }
             }
         }
 
@@ -163,6 +461,91 @@ namespace banim {
                 currentAnimation_ = nullptr;
             }
         }
+        time_ += dt;
+    }
+
+    void Scene::setSeekable(bool seekable) {
+        seekable_ = seekable;
+        if (seekable_) return;
+        checkpoints_.clear();
+        tracked_.clear();
+        trackedSet_.clear();
+    }
+
+    void Scene::track(const std::shared_ptr<Animatable>& animatable) {
+        if (!seekable_ || !trackedSet_.insert(animatable.get()).second) return;
+        TrackedObject object{animatable, nullptr};
+        if (!checkpoints_.empty()) {
+            object.initial = std::make_unique<StateBuffer>();
+            animatable->saveState(*object.initial);
+        }
+        tracked_.push_back(std::move(object));
+    }
+
+    void Scene::saveCheckpoint() {
+        Checkpoint checkpoint;
+        checkpoint.time = time_;
+        checkpoint.timelineIndex = timelineIndex_;
+        checkpoint.trackedCount = tracked_.size();
+        checkpoint.animatables = animatables_;
+        for (const auto& object : tracked_) object.animatable->saveState(checkpoint.state);
+        checkpoint.camera = camera_;
+        checkpoint.cameraSet = cameraSet_;
+        checkpoints_.push_back(std::move(checkpoint));
+    }
+
+    void Scene::restoreCheckpoint(Checkpoint& checkpoint) {
+        checkpoint.state.rewind();
+        for (size_t i = 0; i < tracked_.size(); ++i) {
+            TrackedObject& object = tracked_[i];
+            if (i < checkpoint.trackedCount) {
+                object.animatable->restoreState(checkpoint.state);
+            } else if (object.initial) {
+                object.initial->rewind();
+                object.animatable->restoreState(*object.initial);
+            }
+        }
+        animatables_ = checkpoint.animatables;
+        camera_ = checkpoint.camera;
+        cameraSet_ = checkpoint.cameraSet;
+        
+        // Everything from the checkpoint on plays again from the beginning
+        for (size_t i = checkpoint.timelineIndex; i < timeline_.size(); ++i) {
+            const TimelineAction& action = timeline_[i];
+            if (std::holds_alternative<std::shared_ptr<Animation>>(action)) {
+                std::get<std::shared_ptr<Animation>>(action)->reset();
+            } else if (std::holds_alternative<AddAction>(action)) {
+                const AddAction& addAction = std::get<AddAction>(action);
+                if (addAction.spawnAnimation) addAction.spawnAnimation->reset();
+            }
+        }
+        currentAnimation_ = nullptr;
+        timelineIndex_ = checkpoint.timelineIndex;
+        time_ = checkpoint.time;
+        
+        drawStates_.clear();
+        spatialIndex_.clear();
+        fullDamage_ = true;
+        staticLayerValid_ = false;
+    }
+
+    float Scene::seek(float time, float step) {
+        time = std::max(time, 0.0f);
+        if (seekable_) {
+            if (checkpoints_.empty()) saveCheckpoint();
+            
+            auto later = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), time,
+                                          [](float t, const Checkpoint& c) { return t < c.time; });
+            Checkpoint& nearest = *(later - 1);
+            if (time < time_ || nearest.time > time_) restoreCheckpoint(nearest);
+        }
+        
+        // Whole steps only, as playback takes them: a short last step would
+        // leave animations ending a frame later than they did when played
+        while (time - time_ >= step * 0.5f && !isFinished()) {
+            update(step);
+        }
+        return time_;
     }
 
 } // namespace banim
@@ -0,0 +1,87 @@
+#include "banim/spatial_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace banim {
+
+namespace {
+
+// Objects covering more buckets than this are not bucketed
+constexpr long long kMaxBucketsPerObject = 256;
+
+void eraseId(std::vector<int>& ids, int id) {
+    auto it = std::find(ids.begin(), ids.end(), id);
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+}
+
+} // namespace
+
+SpatialIndex::Span SpatialIndex::span(const PixelRect& rect) const {
+    return {static_cast<int>(std::floor(rect.x0 / bucketSize_)),
+            static_cast<int>(std::floor(rect.y0 / bucketSize_)),
+            static_cast<int>(std::floor(rect.x1 / bucketSize_)),
+            static_cast<int>(std::floor(rect.y1 / bucketSize_))};
+}
+
+void SpatialIndex::clear() {
+    buckets_.clear();
+    oversized_.clear();
+}
+
+void SpatialIndex::insert(int id, const PixelRect& bounds) {
+    if (bounds.empty()) return;
+    Span s = span(bounds);
+    if (s.count() > kMaxBucketsPerObject) {
+        oversized_.push_back(id);
+        return;
+    }
+    for (int y = s.y0; y <= s.y1; ++y)
+        for (int x = s.x0; x <= s.x1; ++x) buckets_[key(x, y)].push_back(id);
+}
+
+void SpatialIndex::remove(int id, const PixelRect& bounds) {
+    if (bounds.empty()) return;
+    Span s = span(bounds);
+    if (s.count() > kMaxBucketsPerObject) {
+        eraseId(oversized_, id);
+        return;
+    }
+    for (int y = s.y0; y <= s.y1; ++y) {
+        for (int x = s.x0; x <= s.x1; ++x) {
+            auto it = buckets_.find(key(x, y));
+            if (it == buckets_.end()) continue;
+            eraseId(it->second, id);
+            if (it->second.empty()) buckets_.erase(it);
+        }
+    }
+}
+
+void SpatialIndex::update(int id, const PixelRect& oldBounds, const PixelRect& newBounds) {
+    // Most moves stay within the same buckets
+    if (!oldBounds.empty() && !newBounds.empty()) {
+        Span a = span(oldBounds), b = span(newBounds);
+        if (a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1) return;
+    }
+    remove(id, oldBounds);
+    insert(id, newBounds);
+}
+
+void SpatialIndex::query(const PixelRect& rect, std::vector<int>& out) const {
+    out.assign(oversized_.begin(), oversized_.end());
+    if (!rect.empty()) {
+        Span s = span(rect);
+        for (int y = s.y0; y <= s.y1; ++y) {
+            for (int x = s.x0; x <= s.x1; ++x) {
+                auto it = buckets_.find(key(x, y));
+                if (it != buckets_.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+} // namespace banim
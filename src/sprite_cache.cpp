@@ -0,0 +1,62 @@
+#include "banim/sprite_cache.h"
+#include <cmath>
+
+namespace banim {
+
+namespace {
+
+constexpr int kMaxSpriteSide = 4096; // Larger objects are drawn directly
+
+bool isWholePixel(float d) { return std::fabs(d - std::round(d)) < 1e-3f; }
+
+} // namespace
+
+void SpriteCache::update(const Key& key, const PixelRect& bounds, float anchorX, float anchorY,
+                         const RenderContext& ctx, const std::function<void(cairo_t*)>& render) {
+    int x0 = static_cast<int>(std::floor(bounds.x0));
+    int y0 = static_cast<int>(std::floor(bounds.y0));
+    int w = static_cast<int>(std::ceil(bounds.x1)) - x0;
+    int h = static_cast<int>(std::ceil(bounds.y1)) - y0;
+    if (bounds.empty() || w > kMaxSpriteSide || h > kMaxSpriteSide) {
+        surface_.reset();
+        return;
+    }
+
+    // A moving object is composited at fractional offsets (bilinear filtered);
+    // once it comes to rest off the cached subpixel phase it is re-rasterized
+    // so it settles crisp.
+    bool moved = anchorX != lastX_ || anchorY != lastY_;
+    bool offPhase = !isWholePixel(anchorX - rasterX_) || !isWholePixel(anchorY - rasterY_);
+    lastX_ = anchorX;
+    lastY_ = anchorY;
+    if (surface_ && key == key_ && antialias_ == ctx.quality.antialias && !(offPhase && !moved))
+        return;
+
+    surface_.reset(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h));
+    cairo_t* sprite = cairo_create(surface_.get());
+    cairo_set_antialias(sprite, ctx.quality.antialias);
+    cairo_translate(sprite, -x0, -y0);
+    render(sprite);
+    cairo_destroy(sprite);
+    cairo_surface_flush(surface_.get());
+
+    key_ = key;
+    antialias_ = ctx.quality.antialias;
+    offsetX_ = static_cast<float>(x0) - anchorX;
+    offsetY_ = static_cast<float>(y0) - anchorY;
+    rasterX_ = anchorX;
+    rasterY_ = anchorY;
+}
+
+void SpriteCache::composite(cairo_t* cr, float anchorX, float anchorY, float alpha) const {
+    if (!surface_ || alpha <= 0.0f) return;
+    cairo_save(cr);
+    cairo_set_source_surface(cr, surface_.get(), anchorX + offsetX_, anchorY + offsetY_);
+    if (alpha >= 1.0f)
+        cairo_paint(cr);
+    else
+        cairo_paint_with_alpha(cr, alpha);
+    cairo_restore(cr);
+}
+
+} // namespace banim
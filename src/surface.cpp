@@ -0,0 +1,193 @@
+#include "banim/surface.h"
+#include "banim/scene.h"
+#include "banim/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace banim {
+
+CairoSurface::CairoSurface(int w, int h) { recreate(w, h); }
+CairoSurface::CairoSurface(unsigned char *data, int w, int h, int stride) {
+    recreate(data, w, h, stride);
+}
+CairoSurface::~CairoSurface() { release(); }
+void CairoSurface::recreate(int w, int h) {
+    release();
+    attach(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h), w, h);
+}
+void CairoSurface::recreate(unsigned char *data, int w, int h, int stride) {
+    release();
+    attach(cairo_image_surface_create_for_data(data, CAIRO_FORMAT_ARGB32, w, h, stride), w, h);
+}
+void CairoSurface::release() {
+    if (cr_) {
+        cairo_destroy(cr_);
+        cr_ = nullptr;
+    }
+    if (surf_) {
+        cairo_surface_destroy(surf_);
+        surf_ = nullptr;
+    }
+}
+void CairoSurface::attach(cairo_surface_t *surf, int w, int h) {
+    surf_ = surf;
+    if (cairo_surface_status(surf_) != CAIRO_STATUS_SUCCESS)
+        throw std::runtime_error("Cairo surface creation failed");
+    cr_ = cairo_create(surf_);
+    if (cairo_status(cr_) != CAIRO_STATUS_SUCCESS)
+        throw std::runtime_error("Cairo context creation failed");
+    w_ = w;
+    h_ = h;
+    hasContent_ = false;
+}
+
+void CairoSurface::setScale(float scale) {
+    if (scale == scale_)
+        return;
+    scale_ = scale;
+    hasContent_ = false;
+}
+
+namespace {
+
+// Rect in scene pixels grown to whole pixels of a surface drawn at scale
+PixelRect alignToSurface(const PixelRect &r, float scale) {
+    return {std::floor(r.x0 * scale) / scale, std::floor(r.y0 * scale) / scale,
+            std::ceil(r.x1 * scale) / scale, std::ceil(r.y1 * scale) / scale};
+}
+
+// Collect the frame's damage into region; false if nothing needs repainting
+bool beginFrame(Scene &scene, CairoSurface &target, DamageRegion &region) {
+    scene.collectDamage(target.width(), target.height(), region);
+    if (!target.hasContent())
+        region.addFull();
+    return !region.empty();
+}
+
+void paintBackground(cairo_t *cr) {
+    // Use dark background for better contrast with educational content
+    cairo_set_source_rgb(cr, 0.1, 0.1, 0.15);  // Dark blue-gray background
+    cairo_paint(cr);
+}
+
+} // namespace
+
+void rasterizeFrame(Scene &scene, CairoSurface &target, DamageRegion *damage) {
+    DamageRegion local;
+    DamageRegion &region = damage ? *damage : local;
+    if (!beginFrame(scene, target, region))
+        return;
+
+    const float scale = target.scale();
+    cairo_t *cr = target.context();
+    cairo_save(cr);
+    if (scale != 1.0f) {
+        // Clip to whole surface pixels, or repainted edges would blend
+        // with the previous frame
+        cairo_scale(cr, scale, scale);
+        if (region.isFull()) {
+            cairo_rectangle(cr, 0, 0, target.width(), target.height());
+        } else {
+            for (const auto &r : region.rects()) {
+                PixelRect a = alignToSurface(r, scale);
+                cairo_rectangle(cr, a.x0, a.y0, a.width(), a.height());
+            }
+        }
+        cairo_clip(cr);
+    } else if (!region.isFull()) {
+        for (const auto &r : region.rects())
+            cairo_rectangle(cr, r.x0, r.y0, r.width(), r.height());
+        cairo_clip(cr);
+    }
+    paintBackground(cr);
+    scene.renderScene(cr, scene.renderContext(target.width(), target.height()));
+    cairo_restore(cr);
+    cairo_surface_flush(target.surface());
+    target.setHasContent(true);
+
+    if (scale != 1.0f) {
+        // Report the damage in surface pixels
+        DamageRegion scaled(target.width(), target.height());
+        if (region.isFull()) {
+            scaled.add({0.0f, 0.0f, target.width() * scale, target.height() * scale});
+        } else {
+            for (const auto &r : region.rects())
+                scaled.add({r.x0 * scale, r.y0 * scale, r.x1 * scale, r.y1 * scale});
+        }
+        region = scaled;
+    }
+}
+
+void rasterizeFrameTiled(Scene &scene, CairoSurface &target, ThreadPool &pool,
+                         DamageRegion *damage, int tileSize) {
+    if (target.scale() != 1.0f) {
+        rasterizeFrame(scene, target, damage);
+        return;
+    }
+
+    DamageRegion local;
+    DamageRegion &region = damage ? *damage : local;
+    if (!beginFrame(scene, target, region))
+        return;
+
+    const int width = target.width();
+    const int height = target.height();
+    tileSize = std::max(tileSize, 16);
+
+    std::vector<PixelRect> tiles;
+    PixelRect damaged;
+    for (const auto &r : region.rects())
+        damaged = damaged.united(r);
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize) {
+            PixelRect tile{static_cast<float>(x), static_cast<float>(y),
+                           static_cast<float>(std::min(x + tileSize, width)),
+                           static_cast<float>(std::min(y + tileSize, height))};
+            if (region.intersects(tile))
+                tiles.push_back(tile);
+        }
+    }
+
+    // Every cache the tiles read is refreshed here, on this thread
+    const RenderContext ctx = scene.renderContext(width, height);
+    scene.prepareRender(ctx, damaged);
+
+    cairo_surface_flush(target.surface());
+    unsigned char *data = cairo_image_surface_get_data(target.surface());
+    const int stride = cairo_image_surface_get_stride(target.surface());
+
+    pool.parallelFor(static_cast<int>(tiles.size()), [&](int i) {
+        const PixelRect &tile = tiles[i];
+        const int x0 = static_cast<int>(tile.x0);
+        const int y0 = static_cast<int>(tile.y0);
+
+        // The tile's pixels inside the shared image, addressed with its stride
+        cairo_surface_t *surface = cairo_image_surface_create_for_data(
+            data + static_cast<size_t>(y0) * stride + static_cast<size_t>(x0) * 4,
+            CAIRO_FORMAT_ARGB32, static_cast<int>(tile.width()), static_cast<int>(tile.height()),
+            stride);
+        cairo_t *cr = cairo_create(surface);
+        cairo_translate(cr, -x0, -y0);
+        if (!region.isFull()) {
+            for (const auto &r : region.rects()) {
+                PixelRect part = r.intersected(tile);
+                if (!part.empty())
+                    cairo_rectangle(cr, part.x0, part.y0, part.width(), part.height());
+            }
+            cairo_clip(cr);
+        }
+        paintBackground(cr);
+        scene.drawPrepared(cr, ctx);
+        cairo_destroy(cr);
+        cairo_surface_flush(surface);
+        cairo_surface_destroy(surface);
+    });
+
+    cairo_surface_mark_dirty(target.surface());
+    scene.finishRender();
+    target.setHasContent(true);
+}
+
+} // namespace banim
@@ -0,0 +1,93 @@
+#include "banim/text_cache.h"
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace banim {
+
+namespace {
+
+// Animated font sizes would otherwise grow the cache without bound; runs hold
+// their own references, so dropping the table is always safe.
+constexpr size_t kMaxCachedFonts = 256;
+
+struct FontCache {
+    using Key = std::tuple<std::string, cairo_font_weight_t, float>;
+
+    std::mutex mutex;
+    std::map<Key, cairo_scaled_font_t*> fonts;
+
+    ~FontCache() { clear(); }
+
+    void clear() {
+        for (auto& entry : fonts) cairo_scaled_font_destroy(entry.second);
+        fonts.clear();
+    }
+};
+
+FontCache& fontCache() {
+    static FontCache cache;
+    return cache;
+}
+
+cairo_scaled_font_t* createScaledFont(const char* family, cairo_font_weight_t weight, float size) {
+    cairo_font_face_t* face = cairo_toy_font_face_create(family, CAIRO_FONT_SLANT_NORMAL, weight);
+    cairo_matrix_t fontMatrix, ctm;
+    cairo_matrix_init_scale(&fontMatrix, size, size);
+    cairo_matrix_init_identity(&ctm);
+    cairo_font_options_t* options = cairo_font_options_create();
+    cairo_scaled_font_t* font = cairo_scaled_font_create(face, &fontMatrix, &ctm, options);
+    cairo_font_options_destroy(options);
+    cairo_font_face_destroy(face);
+    return font;
+}
+
+} // namespace
+
+cairo_scaled_font_t* acquireScaledFont(const char* family, cairo_font_weight_t weight, float size) {
+    FontCache& cache = fontCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    FontCache::Key key{family, weight, size};
+    auto it = cache.fonts.find(key);
+    if (it == cache.fonts.end()) {
+        if (cache.fonts.size() >= kMaxCachedFonts) cache.clear();
+        it = cache.fonts.emplace(key, createScaledFont(family, weight, size)).first;
+    }
+    return cairo_scaled_font_reference(it->second);
+}
+
+GlyphRun::~GlyphRun() {
+    if (font_) cairo_scaled_font_destroy(font_);
+}
+
+void GlyphRun::update(const std::string& text, const char* family,
+                      cairo_font_weight_t weight, float size) {
+    if (matches(text, family, weight, size)) return;
+
+    if (font_) cairo_scaled_font_destroy(font_);
+    font_ = acquireScaledFont(family, weight, size);
+    text_ = text;
+    family_ = family;
+    weight_ = weight;
+    size_ = size;
+
+    glyphs_.clear();
+    extents_ = cairo_text_extents_t{};
+
+    cairo_glyph_t* glyphs = nullptr;
+    int count = 0;
+    if (cairo_scaled_font_text_to_glyphs(font_, 0.0, 0.0, text.c_str(), static_cast<int>(text.size()),
+                                         &glyphs, &count, nullptr, nullptr, nullptr) != CAIRO_STATUS_SUCCESS)
+        return;
+    glyphs_.assign(glyphs, glyphs + count);
+    cairo_glyph_free(glyphs);
+    if (!glyphs_.empty())
+        cairo_scaled_font_glyph_extents(font_, glyphs_.data(), static_cast<int>(glyphs_.size()), &extents_);
+}
+
+void GlyphRun::record(DisplayList& list, double x, double y) const {
+    list.showGlyphs(font_, glyphs_.data(), static_cast<int>(glyphs_.size()), x, y);
+}
+
+} // namespace banim
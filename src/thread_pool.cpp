@@ -0,0 +1,74 @@
+#include "banim/thread_pool.h"
+
+namespace banim {
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+    for (int i = 1; i < threads; ++i) workers_.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& job) {
+    if (count <= 0) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = &job;
+    count_ = count;
+    next_ = 0;
+    error_ = nullptr;
+    ++generation_;
+    wake_.notify_all();
+
+    runJobs(lock);
+    done_.wait(lock, [this] { return next_ >= count_ && running_ == 0; });
+    job_ = nullptr;
+
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    unsigned seen = generation_;
+    for (;;) {
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        runJobs(lock);
+    }
+}
+
+void ThreadPool::runJobs(std::unique_lock<std::mutex>& lock) {
+    while (job_ && next_ < count_) {
+        int index = next_++;
+        ++running_;
+        const std::function<void(int)>& job = *job_;
+        lock.unlock();
+        try {
+            job(index);
+        } catch (...) {
+            lock.lock();
+            if (!error_) error_ = std::current_exception();
+            next_ = count_; // Skip the remaining indices
+            --running_;
+            continue;
+        }
+        lock.lock();
+        --running_;
+    }
+    if (running_ == 0) done_.notify_all();
+}
+
+} // namespace banim
@@ -0,0 +1,229 @@
+#include "banim/tween_track.h"
+#include "banim/animatable.h"
+#include "banim/scene.h"
+#include "banim/thread_pool.h"
+#include <algorithm>
+#include <numeric>
+
+namespace banim {
+
+namespace {
+
+// Zero-length tweens jump to their end value without dividing by zero
+constexpr float kMinDuration = 1e-6f;
+
+// Targets per parallel job when applying on the scene's update pool
+constexpr size_t kTargetsPerJob = 128;
+
+uint8_t bit(int property) { return static_cast<uint8_t>(1u << property); }
+
+} // namespace
+
+bool TweenTrack::add(std::shared_ptr<Animatable> target, TweenProperty property, float to,
+                     float start, float duration, EasingId easing) {
+    if (!target) return true;
+    duration = std::max(duration, kMinDuration);
+    auto found = targetIndex_.find(target.get());
+    uint32_t index;
+    if (found != targetIndex_.end()) {
+        index = found->second;
+    } else {
+        index = static_cast<uint32_t>(targets_.size());
+        targetIndex_.emplace(target.get(), index);
+        rectangles_.push_back(dynamic_cast<Rectangle*>(target.get()));
+        targets_.push_back(std::move(target));
+    }
+
+    uint32_t slot = index * kProperties + static_cast<uint32_t>(property);
+    auto& spans = slotSpans_[slot];
+    float finish = start + duration;
+    for (const auto& span : spans) {
+        if (start < span.second && span.first < finish) return false;
+    }
+    spans.emplace_back(start, finish);
+
+    target_.push_back(index);
+    property_.push_back(static_cast<uint8_t>(property));
+    slot_.push_back(slot);
+    start_.push_back(start);
+    finish_.push_back(start + duration);
+    invDuration_.push_back(1.0f / duration);
+    from_.push_back(0.0f);
+    to_.push_back(to);
+    smooth_.push_back(easing == EasingId::SmoothStep ? 1.0f : 0.0f);
+    end_ = std::max(end_, start + duration);
+    sorted_ = false;
+    return true;
+}
+
+void TweenTrack::readProperties() {
+    properties_.assign(targets_.size() * kProperties, 0.0f);
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        const Animatable& target = *targets_[i];
+        float* p = &properties_[i * kProperties];
+        GridCoord pos = target.getGridPos();
+        p[static_cast<int>(TweenProperty::X)] = pos.x;
+        p[static_cast<int>(TweenProperty::Y)] = pos.y;
+        target.getAnimatableSize(p[static_cast<int>(TweenProperty::Width)],
+                                 p[static_cast<int>(TweenProperty::Height)]);
+        p[static_cast<int>(TweenProperty::Alpha)] = target.getAlpha();
+        p[static_cast<int>(TweenProperty::StrokeWidth)] = target.getStrokeWidth();
+        if (rectangles_[i])
+            p[static_cast<int>(TweenProperty::BorderRadius)] = rectangles_[i]->getBorderRadius();
+    }
+}
+
+void TweenTrack::sortRows() {
+    // Rows in start order, so later tweens on a property override earlier ones
+    size_t n = target_.size();
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](uint32_t a, uint32_t b) { return start_[a] < start_[b]; });
+    auto permute = [&order](auto& column) {
+        auto sorted = column;
+        for (size_t i = 0; i < order.size(); ++i) sorted[i] = column[order[i]];
+        column.swap(sorted);
+    };
+    permute(target_);
+    permute(property_);
+    permute(slot_);
+    permute(start_);
+    permute(finish_);
+    permute(invDuration_);
+    permute(to_);
+    permute(smooth_);
+    sorted_ = true;
+}
+
+void TweenTrack::start() {
+    if (!sorted_) sortRows();
+    
+    // Each tween starts where the previous one on its property ends
+    size_t n = target_.size();
+    readProperties();
+    from_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        from_[i] = properties_[slot_[i]];
+        properties_[slot_[i]] = to_[i];
+    }
+    touched_.assign(targets_.size(), 0);
+    touchedTargets_.clear();
+    touchedTargets_.reserve(targets_.size());
+    active_.clear();
+    active_.reserve(n);
+    next_ = 0;
+    started_ = true;
+}
+
+bool TweenTrack::update(float dt) {
+    if (!started_) start();
+    previous_ = elapsed_;
+    elapsed_ += dt;
+
+    // Rows starting during this step join the active list, which stays in
+    // row (start) order so later tweens on a property override earlier ones
+    size_t n = target_.size();
+    while (next_ < n && start_[next_] <= elapsed_) {
+        active_.push_back(static_cast<uint32_t>(next_++));
+    }
+
+    // Evaluate the active rows: no branches in the easing, so the loop
+    // vectorizes apart from the row gather
+    const float time = elapsed_;
+    const uint32_t* active = active_.data();
+    const float* start = start_.data();
+    const float* invDuration = invDuration_.data();
+    const float* from = from_.data();
+    const float* to = to_.data();
+    const float* smooth = smooth_.data();
+    const uint32_t* slot = slot_.data();
+    float* properties = properties_.data();
+    size_t count = active_.size();
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t i = active[k];
+        float t = std::min(std::max((time - start[i]) * invDuration[i], 0.0f), 1.0f);
+        float eased = t * t * (3.0f - 2.0f * t);
+        t += smooth[i] * (eased - t);
+        properties[slot[i]] = from[i] + (to[i] - from[i]) * t;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t target = target_[active[k]];
+        if (!touched_[target]) touchedTargets_.push_back(target);
+        touched_[target] |= bit(property_[active[k]]);
+    }
+    apply();
+
+    // Rows that reached their end value leave the list (objects are left
+    // alone once their tweens end)
+    active_.erase(std::remove_if(active_.begin(), active_.end(),
+                                 [this](uint32_t i) { return finish_[i] <= elapsed_; }),
+                  active_.end());
+
+    return elapsed_ < end_;
+}
+
+void TweenTrack::apply() {
+    // Each target is set on exactly one thread, so the result does not
+    // depend on the pool
+    size_t count = touchedTargets_.size();
+    ThreadPool* pool = scene_ ? scene_->getUpdatePool() : nullptr;
+    if (!pool || pool->size() <= 1 || count < 2 * kTargetsPerJob) {
+        applyTargets(0, count);
+    } else {
+        int jobs = static_cast<int>((count + kTargetsPerJob - 1) / kTargetsPerJob);
+        pool->parallelFor(jobs, [this, count](int job) {
+            size_t begin = static_cast<size_t>(job) * kTargetsPerJob;
+            applyTargets(begin, std::min(begin + kTargetsPerJob, count));
+        });
+    }
+    touchedTargets_.clear();
+}
+
+void TweenTrack::applyTargets(size_t begin, size_t end) {
+    constexpr int X = static_cast<int>(TweenProperty::X);
+    constexpr int Y = static_cast<int>(TweenProperty::Y);
+    constexpr int W = static_cast<int>(TweenProperty::Width);
+    constexpr int H = static_cast<int>(TweenProperty::Height);
+    constexpr int A = static_cast<int>(TweenProperty::Alpha);
+    constexpr int S = static_cast<int>(TweenProperty::StrokeWidth);
+    constexpr int R = static_cast<int>(TweenProperty::BorderRadius);
+
+    for (size_t k = begin; k < end; ++k) {
+        uint32_t i = touchedTargets_[k];
+        uint8_t touched = touched_[i];
+        touched_[i] = 0;
+        Animatable& target = *targets_[i];
+        float* p = &properties_[i * kProperties];
+        
+        // Properties paired in one setter keep the untweened half as it is
+        if (touched & (bit(X) | bit(Y))) {
+            GridCoord pos = target.getGridPos();
+            if (!(touched & bit(X))) p[X] = pos.x;
+            if (!(touched & bit(Y))) p[Y] = pos.y;
+            target.setGridPos(p[X], p[Y]);
+        }
+        if (touched & (bit(W) | bit(H))) {
+            float w, h;
+            target.getAnimatableSize(w, h);
+            if (!(touched & bit(W))) p[W] = w;
+            if (!(touched & bit(H))) p[H] = h;
+            target.setAnimatableSize(p[W], p[H]);
+        }
+        if (touched & bit(A)) target.setAlpha(p[A]);
+        if (touched & bit(S)) target.setStrokeWidth(p[S]);
+        if ((touched & bit(R)) && rectangles_[i]) rectangles_[i]->setBorderRadius(p[R]);
+    }
+}
+
+void TweenTrack::setScene(Scene* scene) {
+    scene_ = scene;
+}
+
+void TweenTrack::reset() {
+    elapsed_ = 0;
+    previous_ = 0;
+    started_ = false;
+}
+
+} // namespace banim
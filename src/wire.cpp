@@ -1,6 +1,6 @@
 #include "banim/wire.h"
 #include "banim/scene.h"
-#include "banim/init.h"
+#include "banim/surface.h"
 #include <cmath>
 #include <algorithm>
 
@@ -18,9 +18,8 @@ Wire::Wire(std::shared_ptr<IPortProvider> fromProvider, const std::string& fromP
     setColor(0.2f, 0.6f, 1.0f, 1.0f); // Blue wire
     setStrokeWidth(2.0f);
     
-    // Store initial provider positions
-    lastFromProviderPos_ = fromProvider_->getGridPos();
-    lastToProviderPos_ = toProvider_->getGridPos();
+    fromProvider_->addPortListener(this);
+    toProvider_->addPortListener(this);
     
     updateRouting();
 }
@@ -38,15 +37,20 @@ Wire::Wire(std::shared_ptr<IPortProvider> fromProvider, PortDirection fromDirect
     setColor(0.2f, 0.6f, 1.0f, 1.0f); // Blue wire
     setStrokeWidth(2.0f);
     
-    // Store initial provider positions
-    lastFromProviderPos_ = fromProvider_->getGridPos();
-    lastToProviderPos_ = toProvider_->getGridPos();
+    fromProvider_->addPortListener(this);
+    toProvider_->addPortListener(this);
     
     updateRouting();
 }
 
+Wire::~Wire() {
+    if (fromProvider_) fromProvider_->removePortListener(this);
+    if (toProvider_) toProvider_->removePortListener(this);
+}
+
 void Wire::updateRouting() {
     if (!fromProvider_ || !toProvider_) return;
+    routingDirty_.store(false, std::memory_order_relaxed);
     
     // Always update endpoints to track port positions
     Port* fromPort = getFromPort();
@@ -63,70 +67,60 @@ void Wire::updateRouting() {
         calculateAutoRoute();
     }
     // If autoRoute is false, preserve existing waypoints but update endpoints
-    
-    // Update stored positions
-    lastFromProviderPos_ = fromProvider_->getGridPos();
-    lastToProviderPos_ = toProvider_->getGridPos();
 }
 
-void Wire::draw(cairo_t* cr) {
-    // Check if blocks have moved and update routing if needed
-    if (needsRoutingUpdate()) {
-        updateRouting();
-    }
-    
-    // Custom drawing for precise port positioning (no cell-centering offset)
-    extern GLContext* g_ctx;
-    if (!g_ctx) return;
-    
-    extern Scene *g_currentScene;
-    if (!g_currentScene) return;
-    
-    // Convert grid coordinates to pixel coordinates without cell-centering offset
-    float windowWidth = static_cast<float>(g_ctx->width());
-    float windowHeight = static_cast<float>(g_ctx->height());
-    
-    const GridConfig& gridConfig = g_currentScene->getGridConfig();
-    float cellWidth = windowWidth / static_cast<float>(gridConfig.cols);
-    float cellHeight = windowHeight / static_cast<float>(gridConfig.rows);
-    
-    cairo_save(cr);
-    
-    cairo_set_source_rgba(cr, r_, g_, b_, a_);
-    cairo_set_line_width(cr, strokeWidth_);
+void Wire::recordPath(DisplayList& list, const RenderContext& ctx) const {
+    // Custom path for precise port positioning (no cell-centering offset)
+    float cellWidth = ctx.cellWidth;
+    float cellHeight = ctx.cellHeight;
     
     // Start from the start position (no +0.5 offset for precise port positioning)
     float currentX = gridPos_.x * cellWidth;
     float currentY = gridPos_.y * cellHeight;
-    cairo_move_to(cr, currentX, currentY);
+    list.moveTo(currentX, currentY);
     
-    // Draw through all waypoints (no +0.5 offset)
+    // Draw through all waypoints (no +0.5 offset). Zoomed out (grid cells
+    // below the detail size), bends closer than half the detail size to the
+    // previous point are not visible, so they are dropped from the path.
+    float minStep = ctx.detailed(std::min(cellWidth, cellHeight))
+                        ? 0.0f : ctx.quality.detailMinPixels * 0.5f;
     for (int i = 0; i < getWaypointCount(); ++i) {
         GridCoord waypoint = getWaypoint(i);
         float waypointX = waypoint.x * cellWidth;
         float waypointY = waypoint.y * cellHeight;
-        cairo_line_to(cr, waypointX, waypointY);
+        if (std::fabs(waypointX - currentX) < minStep && std::fabs(waypointY - currentY) < minStep)
+            continue;
+        list.lineTo(waypointX, waypointY);
+        currentX = waypointX;
+        currentY = waypointY;
     }
     
     // End at the end position (no +0.5 offset)
     GridCoord endPos = getEndPos();
     float endPixelX = endPos.x * cellWidth;
     float endPixelY = endPos.y * cellHeight;
-    cairo_line_to(cr, endPixelX, endPixelY);
-    
-    cairo_stroke(cr);
-    
-    cairo_restore(cr);
+    list.lineTo(endPixelX, endPixelY);
 }
 
-bool Wire::needsRoutingUpdate() {
-    if (!fromProvider_ || !toProvider_) return false;
-    
-    // Check if blocks have moved
-    return (lastFromProviderPos_.x != fromProvider_->getGridPos().x ||
-            lastFromProviderPos_.y != fromProvider_->getGridPos().y ||
-            lastToProviderPos_.x != toProvider_->getGridPos().x ||
-            lastToProviderPos_.y != toProvider_->getGridPos().y);
+void Wire::syncGeometry() {
+    if (routingDirty_.load(std::memory_order_relaxed)) {
+        updateRouting();
+    }
+}
+
+void Wire::restoreState(StateBuffer& state) {
+    Line::restoreState(state);
+    // Providers may be restored to different ports than the line was saved with
+    routingDirty_.store(true, std::memory_order_relaxed);
+}
+
+void Wire::portsChanged(IPortProvider& provider) {
+    routingDirty_.store(true, std::memory_order_relaxed);
+}
+
+PixelRect Wire::getPixelBounds(const RenderContext& ctx) const {
+    // Wires are drawn on exact port positions, without the cell-centering offset
+    return polylineBounds(ctx.cellWidth, ctx.cellHeight, 0.0f);
 }
 
 void Wire::calculateAutoRoute() {